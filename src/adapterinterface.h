@@ -17,6 +17,13 @@
 
 namespace phicore::adapter {
 
+// One write of a batched device command, see updateChannelStates().
+struct ChannelWrite {
+    QString  channelExternalId;
+    QVariant value;
+    CmdId    cmdId = 0;
+};
+
 class AdapterInterface : public QObject
 {
     Q_OBJECT
@@ -37,6 +44,10 @@ public:
     {
         updateChannelState(deviceExternalId, channelExternalId, value, cmdId);
     }
+    void invokeChannelUpdates(const QString &deviceExternalId, const QList<ChannelWrite> &writes)
+    {
+        updateChannelStates(deviceExternalId, writes);
+    }
     void invokeAction(const QString &actionId, const QJsonObject &params, CmdId cmdId)
     {
         invokeAdapterAction(actionId, params, cmdId);
@@ -73,6 +84,8 @@ signals:
 
     void deviceUpdated(const phicore::adapter::Device &device, const phicore::adapter::ChannelList &channels);
     void deviceRemoved(const QString &deviceId);
+    // Changed Device::meta keys only; receivers merge into the last deviceUpdated.
+    void deviceMetaUpdated(const QString &deviceId, const QJsonObject &metaPatch);
 
     void channelUpdated(const QString &deviceId, const phicore::adapter::Channel &channel);
     void channelRemoved(const QString &deviceId, const QString &channelId);
@@ -134,6 +147,15 @@ protected slots:
         emit cmdResult(cr);
     }
 
+    // Several channels of one device changed together (scene, state +
+    // brightness). Adapters that can apply them as one device command should
+    // override this; every cmdId still gets its own CmdResponse.
+    // Default implementation forwards each write to updateChannelState.
+    virtual void updateChannelStates(const QString &deviceExternalId, const QList<ChannelWrite> &writes) {
+        for (const ChannelWrite &write : writes)
+            updateChannelState(deviceExternalId, write.channelExternalId, write.value, write.cmdId);
+    }
+
     // Optional: propagate user-facing device name changes back to the adapter.
     // Default implementation is a no-op. Adapters that support renaming should
     // override this to call the respective remote API.
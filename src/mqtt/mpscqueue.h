@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace phicore {
+
+// Unbounded multi-producer / single-consumer queue (Vyukov). push() is
+// wait-free and may be called from any thread; tryPop() must only be called
+// from the one consumer thread. The queue always owns one sentinel node whose
+// value has already been consumed.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : m_head(new Node())
+        , m_tail(m_head.load(std::memory_order_relaxed))
+    {
+    }
+
+    ~MpscQueue()
+    {
+        T discarded;
+        while (tryPop(discarded)) {
+        }
+        delete m_tail;
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void push(T value)
+    {
+        Node *node = new Node();
+        node->value = std::move(value);
+        Node *prev = m_head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Returns false when the queue is empty or a producer has not finished
+    // linking its node yet; callers rely on their wake-up protocol to retry.
+    bool tryPop(T &out)
+    {
+        Node *tail = m_tail;
+        Node *next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+        out = std::move(next->value);
+        next->value = T();
+        m_tail = next;
+        delete tail;
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node *> next { nullptr };
+        T value {};
+    };
+
+    std::atomic<Node *> m_head;
+    Node *m_tail = nullptr;
+};
+
+} // namespace phicore
@@ -1,13 +1,38 @@
 #include "mqttclient.h"
 
+#include <atomic>
+
+#include <QHash>
+#include <QList>
 #include <QMetaObject>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QTimer>
 
 #include <mosquitto.h>
 
+#include "mpscqueue.h"
+
 namespace phicore {
 
+namespace {
+
+// Inbound messages are handed to the client thread in frames: a frame is
+// flushed when it reaches kInboundBatchMaxMessages or kInboundBatchIntervalMs
+// after its first message, whichever comes first.
+constexpr int kInboundBatchMaxMessages = 256;
+constexpr int kInboundBatchIntervalMs = 2;
+
+struct OutboundMessage {
+    MqttClient::PublishId id = 0;
+    QByteArray topic;
+    QByteArray payload;
+    int qos = 0;
+    bool retain = false;
+};
+
+} // namespace
+
 class MosquittoRuntime
 {
 public:
@@ -43,7 +68,12 @@ public:
     explicit MqttWorker(QObject *parent = nullptr)
         : QObject(parent)
         , m_runtime()
+        , m_inboundTimer(new QTimer(this))
     {
+        m_inboundTimer->setSingleShot(true);
+        m_inboundTimer->setTimerType(Qt::PreciseTimer);
+        m_inboundTimer->setInterval(kInboundBatchIntervalMs);
+        connect(m_inboundTimer, &QTimer::timeout, this, &MqttWorker::flushInbound);
     }
 
     ~MqttWorker() override
@@ -79,6 +109,7 @@ public:
             mosquitto_connect_callback_set(m_mosq, &MqttWorker::handleConnect);
             mosquitto_disconnect_callback_set(m_mosq, &MqttWorker::handleDisconnect);
             mosquitto_message_callback_set(m_mosq, &MqttWorker::handleMessage);
+            mosquitto_publish_v5_callback_set(m_mosq, &MqttWorker::handlePublish);
             mosquitto_log_callback_set(m_mosq, &MqttWorker::handleLog);
         }
 
@@ -118,36 +149,86 @@ public:
             emit errorOccurred(rc, QStringLiteral("MQTT disconnect failed"));
     }
 
-    Q_INVOKABLE bool subscribe(const QString &topicFilter, int qos)
+    Q_INVOKABLE void subscribe(const QString &topicFilter, int qos)
     {
         if (!m_mosq)
-            return false;
+            return;
         int mid = 0;
         const int rc = mosquitto_subscribe(m_mosq, &mid, topicFilter.toUtf8().constData(), qos);
-        if (rc != MOSQ_ERR_SUCCESS) {
+        if (rc != MOSQ_ERR_SUCCESS)
             emit errorOccurred(rc, QStringLiteral("MQTT subscribe failed"));
-            return false;
-        }
-        return true;
     }
 
-    Q_INVOKABLE int publish(const QString &topic, const QByteArray &payload, int qos, bool retain)
+    Q_INVOKABLE void unsubscribe(const QString &topicFilter)
     {
         if (!m_mosq)
-            return -1;
+            return;
         int mid = 0;
-        const int rc = mosquitto_publish(m_mosq,
-                                         &mid,
-                                         topic.toUtf8().constData(),
-                                         payload.size(),
-                                         payload.constData(),
-                                         qos,
-                                         retain);
-        if (rc != MOSQ_ERR_SUCCESS) {
-            emit errorOccurred(rc, QStringLiteral("MQTT publish failed"));
-            return -1;
+        const int rc = mosquitto_unsubscribe(m_mosq, &mid, topicFilter.toUtf8().constData());
+        if (rc != MOSQ_ERR_SUCCESS)
+            emit errorOccurred(rc, QStringLiteral("MQTT unsubscribe failed"));
+    }
+
+    // Called from the publishing thread. Only the first enqueue after a drain
+    // posts a metacall, so a burst of commands costs a single thread hop.
+    void enqueuePublish(OutboundMessage message)
+    {
+        m_outbound.push(std::move(message));
+        // Pairs with the fence in drainOutbound(): either the drain sees
+        // this message or this exchange sees the cleared flag.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_drainScheduled.exchange(true, std::memory_order_seq_cst))
+            QMetaObject::invokeMethod(this, "drainOutbound", Qt::QueuedConnection);
+    }
+
+    Q_INVOKABLE void drainOutbound()
+    {
+        m_drainScheduled.store(false, std::memory_order_seq_cst);
+        // Store-load: the flag must be cleared before the queue is read.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        OutboundMessage message;
+        while (m_outbound.tryPop(message))
+            publishNow(message);
+    }
+
+    Q_INVOKABLE void armInboundFlush()
+    {
+        if (!m_inboundTimer->isActive())
+            m_inboundTimer->start();
+    }
+
+    // Called from the client thread.
+    void setMessageDecoder(MqttClient::MessageDecoder decoder)
+    {
+        QMutexLocker locker(&m_decoderMutex);
+        m_decoder = std::move(decoder);
+    }
+
+    Q_INVOKABLE void flushInbound()
+    {
+        m_inboundTimer->stop();
+        m_inboundFlushArmed.store(false, std::memory_order_seq_cst);
+        m_inboundFlushForced.store(false, std::memory_order_seq_cst);
+        // Store-load: the flags must be cleared before the queue is read,
+        // see enqueueInbound().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        MqttClient::MessageDecoder decoder;
+        {
+            QMutexLocker locker(&m_decoderMutex);
+            decoder = m_decoder;
         }
-        return mid;
+        QList<MqttMessage> batch;
+        batch.reserve(qMin(m_inboundPending.load(std::memory_order_acquire), kInboundBatchMaxMessages));
+        MqttMessage message;
+        while (m_inbound.tryPop(message)) {
+            if (decoder)
+                decoder(message);
+            batch.append(std::move(message));
+        }
+        if (batch.isEmpty())
+            return;
+        m_inboundPending.fetch_sub(static_cast<int>(batch.size()), std::memory_order_acq_rel);
+        emit messagesReceived(batch);
     }
 
     Q_INVOKABLE void shutdown()
@@ -158,11 +239,56 @@ public:
 signals:
     void connected();
     void disconnected();
-    void messageReceived(const QByteArray &message, const QString &topic);
+    void messagesReceived(const QList<phicore::MqttMessage> &messages);
     void errorOccurred(int code, const QString &message);
     void stateChanged(phicore::MqttClient::State state);
+    void published(quint64 publishId, int messageId, int reasonCode);
+    void publishFailed(quint64 publishId, int code);
 
 private:
+    void publishNow(const OutboundMessage &message)
+    {
+        if (!m_mosq) {
+            emit publishFailed(message.id, MOSQ_ERR_NO_CONN);
+            return;
+        }
+        int mid = 0;
+        int rc = MOSQ_ERR_SUCCESS;
+        {
+            // Hold the lock across mosquitto_publish so handlePublish() cannot
+            // observe the mid before it is mapped to its handle.
+            QMutexLocker locker(&m_inflightMutex);
+            rc = mosquitto_publish(m_mosq,
+                                   &mid,
+                                   message.topic.constData(),
+                                   message.payload.size(),
+                                   message.payload.constData(),
+                                   message.qos,
+                                   message.retain);
+            if (rc == MOSQ_ERR_SUCCESS)
+                m_inflight.insert(mid, message.id);
+        }
+        if (rc != MOSQ_ERR_SUCCESS) {
+            emit errorOccurred(rc, QStringLiteral("MQTT publish failed"));
+            emit publishFailed(message.id, rc);
+        }
+    }
+
+    static void handlePublish(struct mosquitto *, void *userdata, int mid, int reasonCode,
+                              const mosquitto_property *)
+    {
+        auto *worker = static_cast<MqttWorker *>(userdata);
+        if (!worker)
+            return;
+        MqttClient::PublishId id = 0;
+        {
+            QMutexLocker locker(&worker->m_inflightMutex);
+            id = worker->m_inflight.take(mid);
+        }
+        if (id != 0)
+            emit worker->published(id, mid, reasonCode);
+    }
+
     static void handleConnect(struct mosquitto *, void *userdata, int rc)
     {
         auto *worker = static_cast<MqttWorker *>(userdata);
@@ -186,6 +312,15 @@ private:
         Q_UNUSED(rc);
         worker->setState(MqttClient::State::Disconnected);
         worker->stopLoop();
+        // QoS 0 messages still queued are dropped without on_publish, and
+        // their mids are reused after reconnecting.
+        QHash<int, MqttClient::PublishId> inflight;
+        {
+            QMutexLocker locker(&worker->m_inflightMutex);
+            inflight.swap(worker->m_inflight);
+        }
+        for (auto it = inflight.cbegin(); it != inflight.cend(); ++it)
+            emit worker->publishFailed(it.value(), MOSQ_ERR_CONN_LOST);
         emit worker->disconnected();
     }
 
@@ -194,8 +329,25 @@ private:
         auto *worker = static_cast<MqttWorker *>(userdata);
         if (!worker || !msg)
             return;
-        const QByteArray payload(static_cast<const char *>(msg->payload), msg->payloadlen);
-        emit worker->messageReceived(payload, QString::fromUtf8(msg->topic));
+        worker->enqueueInbound(MqttMessage::fromRaw(msg->topic, msg->payload, msg->payloadlen));
+    }
+
+    // Called from the mosquitto loop thread. The first message of a frame arms
+    // the flush timer; a full frame forces an immediate flush.
+    void enqueueInbound(MqttMessage message)
+    {
+        m_inbound.push(std::move(message));
+        const int pending = m_inboundPending.fetch_add(1, std::memory_order_acq_rel) + 1;
+        // Pairs with the fence in flushInbound(): either the flush sees this
+        // message or the exchanges below see the cleared flags.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pending >= kInboundBatchMaxMessages) {
+            if (!m_inboundFlushForced.exchange(true, std::memory_order_seq_cst))
+                QMetaObject::invokeMethod(this, "flushInbound", Qt::QueuedConnection);
+            return;
+        }
+        if (!m_inboundFlushArmed.exchange(true, std::memory_order_seq_cst))
+            QMetaObject::invokeMethod(this, "armInboundFlush", Qt::QueuedConnection);
     }
 
     static void handleLog(struct mosquitto *, void *userdata, int level, const char *str)
@@ -234,6 +386,15 @@ private:
             mosquitto_destroy(m_mosq);
             m_mosq = nullptr;
         }
+        QHash<int, MqttClient::PublishId> inflight;
+        {
+            QMutexLocker locker(&m_inflightMutex);
+            inflight.swap(m_inflight);
+        }
+        for (auto it = inflight.cbegin(); it != inflight.cend(); ++it)
+            emit publishFailed(it.value(), MOSQ_ERR_NO_CONN);
+        drainOutbound();
+        flushInbound();
     }
 
     void setState(MqttClient::State state)
@@ -248,6 +409,19 @@ private:
     struct mosquitto *m_mosq = nullptr;
     bool m_loopRunning = false;
 
+    MpscQueue<OutboundMessage> m_outbound;
+    std::atomic_bool m_drainScheduled { false };
+    QMutex m_inflightMutex;
+    QHash<int, MqttClient::PublishId> m_inflight;
+
+    QTimer *m_inboundTimer = nullptr;
+    MpscQueue<MqttMessage> m_inbound;
+    std::atomic_int m_inboundPending { 0 };
+    std::atomic_bool m_inboundFlushArmed { false };
+    std::atomic_bool m_inboundFlushForced { false };
+    QMutex m_decoderMutex;
+    MqttClient::MessageDecoder m_decoder;
+
     QString m_clientId;
     QString m_hostname;
     QString m_username;
@@ -263,13 +437,17 @@ MqttClient::MqttClient(QObject *parent)
     , m_worker(new MqttWorker())
     , m_workerThread(new QThread(this))
 {
+    qRegisterMetaType<phicore::MqttMessage>();
+    qRegisterMetaType<QList<phicore::MqttMessage>>();
     m_worker->moveToThread(m_workerThread);
     connect(m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
 
     connect(m_worker, &MqttWorker::connected, this, &MqttClient::connected);
     connect(m_worker, &MqttWorker::disconnected, this, &MqttClient::disconnected);
-    connect(m_worker, &MqttWorker::messageReceived, this, &MqttClient::messageReceived);
+    connect(m_worker, &MqttWorker::messagesReceived, this, &MqttClient::messagesReceived);
     connect(m_worker, &MqttWorker::errorOccurred, this, &MqttClient::errorOccurred);
+    connect(m_worker, &MqttWorker::published, this, &MqttClient::published);
+    connect(m_worker, &MqttWorker::publishFailed, this, &MqttClient::publishFailed);
     connect(m_worker, &MqttWorker::stateChanged, this, [this](MqttClient::State state) {
         setState(state);
     });
@@ -353,38 +531,46 @@ void MqttClient::disconnectFromHost()
         QMetaObject::invokeMethod(m_worker, "disconnectFromHost", Qt::QueuedConnection);
 }
 
-int MqttClient::publish(const QString &topic, const QByteArray &payload, int qos, bool retain)
+MqttClient::PublishId MqttClient::publish(const QString &topic, const QByteArray &payload, int qos, bool retain)
 {
     if (!m_worker)
-        return -1;
-    if (QThread::currentThread() == m_workerThread)
-        return m_worker->publish(topic, payload, qos, retain);
-    int mid = -1;
-    QMetaObject::invokeMethod(m_worker,
-                              "publish",
-                              Qt::BlockingQueuedConnection,
-                              Q_RETURN_ARG(int, mid),
-                              Q_ARG(QString, topic),
-                              Q_ARG(QByteArray, payload),
-                              Q_ARG(int, qos),
-                              Q_ARG(bool, retain));
-    return mid;
+        return 0;
+    OutboundMessage message;
+    message.id = m_nextPublishId.fetch_add(1, std::memory_order_relaxed) + 1;
+    message.topic = topic.toUtf8();
+    message.payload = payload;
+    message.qos = qos;
+    message.retain = retain;
+    const PublishId id = message.id;
+    m_worker->enqueuePublish(std::move(message));
+    return id;
+}
+
+void MqttClient::setMessageDecoder(MessageDecoder decoder)
+{
+    if (m_worker)
+        m_worker->setMessageDecoder(std::move(decoder));
 }
 
 bool MqttClient::subscribe(const QString &topicFilter, int qos)
 {
     if (!m_worker)
         return false;
-    if (QThread::currentThread() == m_workerThread)
-        return m_worker->subscribe(topicFilter, qos);
-    bool ok = false;
-    QMetaObject::invokeMethod(m_worker,
-                              "subscribe",
-                              Qt::BlockingQueuedConnection,
-                              Q_RETURN_ARG(bool, ok),
-                              Q_ARG(QString, topicFilter),
-                              Q_ARG(int, qos));
-    return ok;
+    return QMetaObject::invokeMethod(m_worker,
+                                     "subscribe",
+                                     Qt::QueuedConnection,
+                                     Q_ARG(QString, topicFilter),
+                                     Q_ARG(int, qos));
+}
+
+bool MqttClient::unsubscribe(const QString &topicFilter)
+{
+    if (!m_worker)
+        return false;
+    return QMetaObject::invokeMethod(m_worker,
+                                     "unsubscribe",
+                                     Qt::QueuedConnection,
+                                     Q_ARG(QString, topicFilter));
 }
 
 void MqttClient::setState(State state)
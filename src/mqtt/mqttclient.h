@@ -1,9 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+
 #include <QByteArray>
+#include <QList>
 #include <QObject>
 #include <QThread>
 
+#include "mqttmessage.h"
+
 namespace phicore {
 
 class MqttWorker;
@@ -20,6 +26,13 @@ public:
     };
     Q_ENUM(State)
 
+    // Opaque handle for a queued publish. 0 is never a valid handle.
+    using PublishId = quint64;
+    // Runs on the worker thread for every inbound message, in arrival order,
+    // before the message is handed to messagesReceived(). It must not touch
+    // state owned by other threads; capture what it needs by value.
+    using MessageDecoder = std::function<void(MqttMessage &message)>;
+
     explicit MqttClient(QObject *parent = nullptr);
     ~MqttClient() override;
 
@@ -36,15 +49,26 @@ public:
     void connectToHost();
     void disconnectFromHost();
 
-    int publish(const QString &topic, const QByteArray &payload, int qos = 0, bool retain = false);
+    // Enqueues the message for the worker thread and returns immediately.
+    // The returned handle is resolved exactly once through published() or
+    // publishFailed(). Returns 0 if the message could not be queued at all.
+    PublishId publish(const QString &topic, const QByteArray &payload, int qos = 0, bool retain = false);
+    // Queued to the worker thread; failures are reported via errorOccurred().
     bool subscribe(const QString &topicFilter, int qos = 0);
+    bool unsubscribe(const QString &topicFilter);
+    void setMessageDecoder(MessageDecoder decoder);
 
 signals:
     void connected();
     void disconnected();
-    void messageReceived(const QByteArray &message, const QString &topic);
+    // Inbound messages in arrival order, delivered in frames of up to a few
+    // hundred messages so a retained-state flood costs one event per frame.
+    void messagesReceived(const QList<phicore::MqttMessage> &messages);
     void errorOccurred(int code, const QString &message);
     void stateChanged(phicore::MqttClient::State state);
+    // messageId is the mosquitto mid, reasonCode the PUBACK reason (0 = ok).
+    void published(quint64 publishId, int messageId, int reasonCode);
+    void publishFailed(quint64 publishId, int code);
 
 private:
     void setState(State state);
@@ -61,6 +85,7 @@ private:
     int m_keepAliveSeconds = 60;
     bool m_cleanSession = true;
     State m_state = State::Disconnected;
+    std::atomic<PublishId> m_nextPublishId { 0 };
 };
 
 } // namespace phicore
@@ -0,0 +1,206 @@
+#include "mqttmessage.h"
+
+#include <atomic>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace phicore {
+
+namespace {
+
+// Buffers above this capacity (e.g. bridge/devices snapshots) are freed
+// instead of being kept around in the pool.
+constexpr std::size_t kMaxPooledCapacity = 64 * 1024;
+constexpr std::size_t kMaxPooledBuffers = 256;
+
+} // namespace
+
+class MqttMessageBuffer
+{
+public:
+    std::atomic_int ref { 0 };
+    std::vector<char> bytes;
+    qsizetype topicSize = 0;
+    qsizetype payloadSize = 0;
+    bool decoded = false;
+    int tag = 0;
+    QJsonDocument document;
+    QString subject;
+    quint64 handle = 0;
+};
+
+namespace {
+
+class MqttMessagePool
+{
+public:
+    MqttMessageBuffer *acquire()
+    {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_free.empty()) {
+                MqttMessageBuffer *buffer = m_free.back();
+                m_free.pop_back();
+                return buffer;
+            }
+        }
+        return new MqttMessageBuffer();
+    }
+
+    void release(MqttMessageBuffer *buffer)
+    {
+        buffer->decoded = false;
+        buffer->tag = 0;
+        buffer->document = QJsonDocument();
+        buffer->subject.clear();
+        buffer->handle = 0;
+        if (buffer->bytes.capacity() <= kMaxPooledCapacity) {
+            QMutexLocker locker(&m_mutex);
+            if (m_free.size() < kMaxPooledBuffers) {
+                m_free.push_back(buffer);
+                return;
+            }
+        }
+        delete buffer;
+    }
+
+private:
+    QMutex m_mutex;
+    std::vector<MqttMessageBuffer *> m_free;
+};
+
+MqttMessagePool &pool()
+{
+    // Intentionally leaked: messages may still be released during static
+    // destruction.
+    static MqttMessagePool *instance = new MqttMessagePool();
+    return *instance;
+}
+
+void retain(MqttMessageBuffer *buffer) noexcept
+{
+    if (buffer)
+        buffer->ref.fetch_add(1, std::memory_order_relaxed);
+}
+
+void releaseRef(MqttMessageBuffer *buffer) noexcept
+{
+    if (buffer && buffer->ref.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        pool().release(buffer);
+}
+
+} // namespace
+
+MqttMessage::MqttMessage(const MqttMessage &other) noexcept
+    : m_buffer(other.m_buffer)
+{
+    retain(m_buffer);
+}
+
+MqttMessage::MqttMessage(MqttMessage &&other) noexcept
+    : m_buffer(std::exchange(other.m_buffer, nullptr))
+{
+}
+
+MqttMessage &MqttMessage::operator=(const MqttMessage &other) noexcept
+{
+    if (m_buffer != other.m_buffer) {
+        retain(other.m_buffer);
+        releaseRef(m_buffer);
+        m_buffer = other.m_buffer;
+    }
+    return *this;
+}
+
+MqttMessage &MqttMessage::operator=(MqttMessage &&other) noexcept
+{
+    if (this != &other) {
+        releaseRef(m_buffer);
+        m_buffer = std::exchange(other.m_buffer, nullptr);
+    }
+    return *this;
+}
+
+MqttMessage::~MqttMessage()
+{
+    releaseRef(m_buffer);
+}
+
+MqttMessage MqttMessage::fromRaw(const char *topic, const void *payload, int payloadSize)
+{
+    const std::size_t topicSize = topic ? std::strlen(topic) : 0;
+    const std::size_t bodySize = (payload && payloadSize > 0) ? static_cast<std::size_t>(payloadSize) : 0;
+
+    MqttMessageBuffer *buffer = pool().acquire();
+    buffer->bytes.resize(topicSize + bodySize);
+    if (topicSize > 0)
+        std::memcpy(buffer->bytes.data(), topic, topicSize);
+    if (bodySize > 0)
+        std::memcpy(buffer->bytes.data() + topicSize, payload, bodySize);
+    buffer->topicSize = static_cast<qsizetype>(topicSize);
+    buffer->payloadSize = static_cast<qsizetype>(bodySize);
+    buffer->ref.store(1, std::memory_order_relaxed);
+    return MqttMessage(buffer);
+}
+
+QByteArrayView MqttMessage::topic() const noexcept
+{
+    if (!m_buffer)
+        return {};
+    return QByteArrayView(m_buffer->bytes.data(), m_buffer->topicSize);
+}
+
+QByteArrayView MqttMessage::payload() const noexcept
+{
+    if (!m_buffer)
+        return {};
+    return QByteArrayView(m_buffer->bytes.data() + m_buffer->topicSize, m_buffer->payloadSize);
+}
+
+QByteArray MqttMessage::payloadBytes() const
+{
+    const QByteArrayView view = payload();
+    return QByteArray::fromRawData(view.data(), view.size());
+}
+
+void MqttMessage::setDecoded(int tag, QJsonDocument document, QString subject, quint64 handle)
+{
+    if (!m_buffer)
+        return;
+    m_buffer->decoded = true;
+    m_buffer->tag = tag;
+    m_buffer->document = std::move(document);
+    m_buffer->subject = std::move(subject);
+    m_buffer->handle = handle;
+}
+
+bool MqttMessage::isDecoded() const noexcept
+{
+    return m_buffer && m_buffer->decoded;
+}
+
+int MqttMessage::tag() const noexcept
+{
+    return m_buffer ? m_buffer->tag : 0;
+}
+
+QJsonDocument MqttMessage::document() const
+{
+    return m_buffer ? m_buffer->document : QJsonDocument();
+}
+
+QString MqttMessage::subject() const
+{
+    return m_buffer ? m_buffer->subject : QString();
+}
+
+quint64 MqttMessage::handle() const noexcept
+{
+    return m_buffer ? m_buffer->handle : 0;
+}
+
+} // namespace phicore
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonDocument>
+#include <QMetaType>
+#include <QString>
+
+namespace phicore {
+
+class MqttMessageBuffer;
+
+// Immutable inbound MQTT message backed by a pooled, ref-counted buffer that
+// holds the raw topic and payload bytes. Copies share the buffer; the last
+// copy returns it to the pool. Views stay valid while any copy is alive.
+class MqttMessage
+{
+public:
+    MqttMessage() = default;
+    MqttMessage(const MqttMessage &other) noexcept;
+    MqttMessage(MqttMessage &&other) noexcept;
+    MqttMessage &operator=(const MqttMessage &other) noexcept;
+    MqttMessage &operator=(MqttMessage &&other) noexcept;
+    ~MqttMessage();
+
+    // Copies topic and payload once into a buffer taken from the pool.
+    static MqttMessage fromRaw(const char *topic, const void *payload, int payloadSize);
+
+    bool isNull() const noexcept { return m_buffer == nullptr; }
+
+    QByteArrayView topic() const noexcept;
+    QByteArrayView payload() const noexcept;
+
+    // Non-owning QByteArray over the payload for APIs that only take
+    // QByteArray (e.g. QJsonDocument::fromJson). Must not outlive *this.
+    QByteArray payloadBytes() const;
+
+    // Result of the client's decode stage. tag is an application-defined
+    // topic class; document is null when the payload was not (or could not
+    // be) parsed. subject and handle identify what the topic addresses
+    // (e.g. a device name and lookup handle) so the consumer need not route
+    // the topic again. Only set before the message is shared with other
+    // threads.
+    void setDecoded(int tag, QJsonDocument document, QString subject = QString(), quint64 handle = 0);
+    bool isDecoded() const noexcept;
+    int tag() const noexcept;
+    QJsonDocument document() const;
+    QString subject() const;
+    quint64 handle() const noexcept;
+
+private:
+    explicit MqttMessage(MqttMessageBuffer *buffer) noexcept : m_buffer(buffer) {}
+
+    MqttMessageBuffer *m_buffer = nullptr;
+};
+
+} // namespace phicore
+
+Q_DECLARE_METATYPE(phicore::MqttMessage)
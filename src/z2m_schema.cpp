@@ -129,6 +129,14 @@ QJsonArray baseSchemaFields(const QString &parentActionId = QString())
                         {},
                         parentActionId));
 
+    fields.append(field(QStringLiteral("confirmCommands"),
+                        QStringLiteral("Boolean"),
+                        QStringLiteral("Confirm commands"),
+                        QStringLiteral("Report a command only after the device reports the new state."),
+                        QJsonValue(false),
+                        {},
+                        parentActionId));
+
     return fields;
 }
 
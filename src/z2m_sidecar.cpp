@@ -2,13 +2,12 @@
 
 #include <algorithm>
 #include <chrono>
+#include <utility>
 
 #include <QDateTime>
-#include <QEventLoop>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QTimer>
 
 #include "z2m_runtime_convert.h"
 #include "z2m_schema.h"
@@ -82,6 +81,7 @@ void Z2mSidecar::stop()
     m_started = false;
     if (m_runtime)
         m_runtime->stopAdapter();
+    failPending(CmdStatus::TemporarilyOffline, QStringLiteral("Adapter stopped"));
 }
 
 void Z2mSidecar::onConnected()
@@ -93,6 +93,9 @@ void Z2mSidecar::onDisconnected()
     m_started = false;
     if (m_runtime)
         m_runtime->stopAdapter();
+    // Core is gone; nobody is waiting for these results any more.
+    m_timeouts.clear();
+    m_pendingCommands.clear();
 
     v1::Utf8String err;
     sendConnectionStateChanged(false, &err);
@@ -125,16 +128,12 @@ void Z2mSidecar::onChannelInvoke(const phi::ChannelInvokeRequest &request)
     else
         value = parseValueJson(request.valueJson);
 
-    submitCmdResult(waitCmdResponse(
-        request.cmdId,
-        [&]() {
-            m_runtime->invokeChannelUpdate(QString::fromStdString(request.deviceExternalId),
-                                          QString::fromStdString(request.channelExternalId),
-                                          value,
-                                          request.cmdId);
-        },
-        kDefaultTimeoutMs),
-        "channel.invoke");
+    dispatchCmd(request.cmdId, "channel.invoke", [&]() {
+        m_runtime->invokeChannelUpdate(QString::fromStdString(request.deviceExternalId),
+                                      QString::fromStdString(request.channelExternalId),
+                                      value,
+                                      request.cmdId);
+    });
 }
 
 void Z2mSidecar::onAdapterActionInvoke(const phi::AdapterActionInvokeRequest &request)
@@ -158,14 +157,9 @@ void Z2mSidecar::onAdapterActionInvoke(const phi::AdapterActionInvokeRequest &re
 
     const QString actionId = QString::fromStdString(request.actionId).trimmed();
     const QJsonObject params = parseJsonObject(request.paramsJson);
-    submitActionResult(
-        waitActionResponse(
-        request.cmdId,
-        [&]() {
-            m_runtime->invokeAction(actionId, params, request.cmdId);
-        },
-        kDefaultTimeoutMs),
-        "adapter.action.invoke");
+    dispatchAction(request.cmdId, "adapter.action.invoke", [&]() {
+        m_runtime->invokeAction(actionId, params, request.cmdId);
+    });
 }
 
 void Z2mSidecar::onDeviceNameUpdate(const phi::DeviceNameUpdateRequest &request)
@@ -176,15 +170,11 @@ void Z2mSidecar::onDeviceNameUpdate(const phi::DeviceNameUpdateRequest &request)
                                           QStringLiteral("Adapter not started")),
                                "device.name.update");
 
-    submitCmdResult(waitCmdResponse(
-        request.cmdId,
-        [&]() {
-            m_runtime->invokeNameUpdate(QString::fromStdString(request.deviceExternalId),
-                                       QString::fromStdString(request.name),
-                                       request.cmdId);
-        },
-        kDefaultTimeoutMs),
-        "device.name.update");
+    dispatchCmd(request.cmdId, "device.name.update", [&]() {
+        m_runtime->invokeNameUpdate(QString::fromStdString(request.deviceExternalId),
+                                   QString::fromStdString(request.name),
+                                   request.cmdId);
+    });
 }
 
 void Z2mSidecar::onDeviceEffectInvoke(const phi::DeviceEffectInvokeRequest &request)
@@ -196,18 +186,13 @@ void Z2mSidecar::onDeviceEffectInvoke(const phi::DeviceEffectInvokeRequest &requ
 
     const QJsonObject params = parseJsonObject(request.paramsJson);
 
-    submitCmdResult(
-        waitCmdResponse(
-            request.cmdId,
-            [&]() {
-                m_runtime->invokeEffect(QString::fromStdString(request.deviceExternalId),
-                                       static_cast<runtimeapi::DeviceEffect>(request.effect),
-                                       QString::fromStdString(request.effectId),
-                                       params,
-                                       request.cmdId);
-            },
-            kDefaultTimeoutMs),
-        "device.effect.invoke");
+    dispatchCmd(request.cmdId, "device.effect.invoke", [&]() {
+        m_runtime->invokeEffect(QString::fromStdString(request.deviceExternalId),
+                               static_cast<runtimeapi::DeviceEffect>(request.effect),
+                               QString::fromStdString(request.effectId),
+                               params,
+                               request.cmdId);
+    });
 }
 
 void Z2mSidecar::onSceneInvoke(const phi::SceneInvokeRequest &request)
@@ -218,20 +203,26 @@ void Z2mSidecar::onSceneInvoke(const phi::SceneInvokeRequest &request)
                                           QStringLiteral("Adapter not started")),
                                "scene.invoke");
 
-    submitCmdResult(waitCmdResponse(
-        request.cmdId,
-        [&]() {
-            m_runtime->invokeSceneAction(QString::fromStdString(request.sceneExternalId),
-                                        QString::fromStdString(request.groupExternalId),
-                                        QString::fromStdString(request.action),
-                                        request.cmdId);
-        },
-        kDefaultTimeoutMs),
-        "scene.invoke");
+    dispatchCmd(request.cmdId, "scene.invoke", [&]() {
+        m_runtime->invokeSceneAction(QString::fromStdString(request.sceneExternalId),
+                                    QString::fromStdString(request.groupExternalId),
+                                    QString::fromStdString(request.action),
+                                    request.cmdId);
+    });
 }
 
 void Z2mSidecar::wireRuntimeSignals()
 {
+    QObject::connect(m_runtime.get(),
+                     &runtimeapi::AdapterInterface::cmdResult,
+                     m_runtime.get(),
+                     [this](const runtimeapi::CmdResponse &response) { completeCmd(response); });
+
+    QObject::connect(m_runtime.get(),
+                     &runtimeapi::AdapterInterface::actionResult,
+                     m_runtime.get(),
+                     [this](const runtimeapi::ActionResponse &response) { completeAction(response); });
+
     QObject::connect(m_runtime.get(),
                      &runtimeapi::AdapterInterface::connectionStateChanged,
                      m_runtime.get(),
@@ -268,6 +259,20 @@ void Z2mSidecar::wireRuntimeSignals()
                          sendDeviceUpdated(toV1(device), toV1(channels), &err);
                      });
 
+    // The v1 protocol has no partial device message, so a meta patch is
+    // answered with the runtime's current device, which already includes it.
+    QObject::connect(m_runtime.get(),
+                     &runtimeapi::AdapterInterface::deviceMetaUpdated,
+                     m_runtime.get(),
+                     [this](const QString &deviceExternalId, const QJsonObject &) {
+                         runtimeapi::Device device;
+                         runtimeapi::ChannelList channels;
+                         if (!m_runtime->deviceSnapshot(deviceExternalId, device, channels))
+                             return;
+                         v1::Utf8String err;
+                         sendDeviceUpdated(toV1(device), toV1(channels), &err);
+                     });
+
     QObject::connect(m_runtime.get(),
                      &runtimeapi::AdapterInterface::deviceRemoved,
                      m_runtime.get(),
@@ -405,86 +410,83 @@ bool Z2mSidecar::ensureRuntime()
     return true;
 }
 
-Z2mSidecar::CmdResponse Z2mSidecar::waitCmdResponse(std::uint64_t cmdId,
-                                                    const std::function<void()> &invoke,
-                                                    int timeoutMs)
+void Z2mSidecar::dispatchCmd(std::uint64_t cmdId,
+                             const char *context,
+                             const std::function<void()> &invoke,
+                             int timeoutMs)
 {
-    std::optional<runtimeapi::CmdResponse> response;
-
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
-    timer.setInterval(std::max(1000, timeoutMs));
-
-    const QMetaObject::Connection resultConn = QObject::connect(
-        m_runtime.get(),
-        &runtimeapi::AdapterInterface::cmdResult,
-        &loop,
-        [&](const runtimeapi::CmdResponse &runtimeResponse) {
-            if (runtimeResponse.id != cmdId)
-                return;
-            response = runtimeResponse;
-            loop.quit();
-        });
-
-    const QMetaObject::Connection timeoutConn = QObject::connect(&timer, &QTimer::timeout, &loop, [&loop]() {
-        loop.quit();
-    });
-
-    timer.start();
+    // Track first: the runtime may report the result from within invoke().
+    trackPending(cmdId, context, false, timeoutMs);
     invoke();
+}
 
-    if (!response.has_value() && timer.isActive())
-        loop.exec();
-
-    QObject::disconnect(resultConn);
-    QObject::disconnect(timeoutConn);
-
-    if (response.has_value())
-        return toV1(*response);
-
-    return makeFailure(cmdId, CmdStatus::Timeout, QStringLiteral("Command timed out"));
+void Z2mSidecar::dispatchAction(std::uint64_t cmdId,
+                                const char *context,
+                                const std::function<void()> &invoke,
+                                int timeoutMs)
+{
+    trackPending(cmdId, context, true, timeoutMs);
+    invoke();
 }
 
-Z2mSidecar::ActionResponse Z2mSidecar::waitActionResponse(std::uint64_t cmdId,
-                                                          const std::function<void()> &invoke,
-                                                          int timeoutMs)
+void Z2mSidecar::trackPending(std::uint64_t cmdId, const char *context, bool isAction, int timeoutMs)
 {
-    std::optional<runtimeapi::ActionResponse> response;
-
-    QEventLoop loop;
-    QTimer timer;
-    timer.setSingleShot(true);
-    timer.setInterval(std::max(1000, timeoutMs));
-
-    const QMetaObject::Connection resultConn = QObject::connect(
-        m_runtime.get(),
-        &runtimeapi::AdapterInterface::actionResult,
-        &loop,
-        [&](const runtimeapi::ActionResponse &runtimeResponse) {
-            if (runtimeResponse.id != cmdId)
-                return;
-            response = runtimeResponse;
-            loop.quit();
-        });
-
-    const QMetaObject::Connection timeoutConn = QObject::connect(&timer, &QTimer::timeout, &loop, [&loop]() {
-        loop.quit();
+    PendingCommand &pending = m_pendingCommands[cmdId];
+    m_timeouts.cancel(pending.timeout);
+    pending.context = context;
+    pending.isAction = isAction;
+    pending.timeout = m_timeouts.schedule(std::max(1000, timeoutMs), [this, cmdId]() {
+        expirePending(cmdId);
     });
+}
 
-    timer.start();
-    invoke();
-
-    if (!response.has_value() && timer.isActive())
-        loop.exec();
+void Z2mSidecar::completeCmd(const runtimeapi::CmdResponse &response)
+{
+    const auto it = m_pendingCommands.constFind(response.id);
+    if (it == m_pendingCommands.cend() || it.value().isAction)
+        return;
+    const PendingCommand pending = it.value();
+    m_pendingCommands.erase(it);
+    m_timeouts.cancel(pending.timeout);
+    submitCmdResult(toV1(response), pending.context);
+}
 
-    QObject::disconnect(resultConn);
-    QObject::disconnect(timeoutConn);
+void Z2mSidecar::completeAction(const runtimeapi::ActionResponse &response)
+{
+    const auto it = m_pendingCommands.constFind(response.id);
+    if (it == m_pendingCommands.cend() || !it.value().isAction)
+        return;
+    const PendingCommand pending = it.value();
+    m_pendingCommands.erase(it);
+    m_timeouts.cancel(pending.timeout);
+    submitActionResult(toV1(response), pending.context);
+}
 
-    if (response.has_value())
-        return toV1(*response);
+void Z2mSidecar::expirePending(std::uint64_t cmdId)
+{
+    const auto it = m_pendingCommands.constFind(cmdId);
+    if (it == m_pendingCommands.cend())
+        return;
+    const PendingCommand pending = it.value();
+    m_pendingCommands.erase(it);
+    if (pending.isAction)
+        submitActionResult(makeActionFailure(cmdId, CmdStatus::Timeout, QStringLiteral("Action timed out")),
+                           pending.context);
+    else
+        submitCmdResult(makeFailure(cmdId, CmdStatus::Timeout, QStringLiteral("Command timed out")),
+                        pending.context);
+}
 
-    return makeActionFailure(cmdId, CmdStatus::Timeout, QStringLiteral("Action timed out"));
+void Z2mSidecar::failPending(CmdStatus status, const QString &message)
+{
+    const QHash<std::uint64_t, PendingCommand> pendingCommands = std::exchange(m_pendingCommands, {});
+    m_timeouts.clear();
+    for (auto it = pendingCommands.cbegin(); it != pendingCommands.cend(); ++it) {
+        if (it.value().isAction)
+            submitActionResult(makeActionFailure(it.key(), status, message), it.value().context);
+        else
+            submitCmdResult(makeFailure(it.key(), status, message), it.value().context);
+    }
 }
 
 Z2mSidecar::CmdResponse Z2mSidecar::makeFailure(std::uint64_t cmdId,
@@ -3,9 +3,11 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
-#include <optional>
 
+#include <QHash>
 #include <QJsonObject>
+#include <QObject>
+#include <QString>
 
 #include "z2madapter.h"
 #include "phi/adapter/sdk/sidecar.h"
@@ -43,6 +45,12 @@ private:
     using ActionResponse = phicore::adapter::v1::ActionResponse;
     using CmdStatus = phicore::adapter::v1::CmdStatus;
 
+    struct PendingCommand {
+        const char *context = nullptr;
+        bool isAction = false;
+        phicore::adapter::Z2mTimerWheel::Handle timeout = 0;
+    };
+
     void submitCmdResult(CmdResponse response, const char *context);
     void submitActionResult(ActionResponse response, const char *context);
 
@@ -50,12 +58,21 @@ private:
     void applyRuntimeConfig(const phicore::adapter::sdk::ConfigChangedRequest &request);
     bool ensureRuntime();
 
-    CmdResponse waitCmdResponse(std::uint64_t cmdId,
-                                const std::function<void()> &invoke,
-                                int timeoutMs = 15000);
-    ActionResponse waitActionResponse(std::uint64_t cmdId,
-                                      const std::function<void()> &invoke,
-                                      int timeoutMs = 15000);
+    // Commands are tracked by cmdId and answered when the runtime reports
+    // the result or the timeout expires, so any number can be in flight.
+    void dispatchCmd(std::uint64_t cmdId,
+                     const char *context,
+                     const std::function<void()> &invoke,
+                     int timeoutMs = kDefaultTimeoutMs);
+    void dispatchAction(std::uint64_t cmdId,
+                        const char *context,
+                        const std::function<void()> &invoke,
+                        int timeoutMs = kDefaultTimeoutMs);
+    void trackPending(std::uint64_t cmdId, const char *context, bool isAction, int timeoutMs);
+    void completeCmd(const phicore::adapter::CmdResponse &response);
+    void completeAction(const phicore::adapter::ActionResponse &response);
+    void expirePending(std::uint64_t cmdId);
+    void failPending(CmdStatus status, const QString &message);
 
     CmdResponse makeFailure(std::uint64_t cmdId, CmdStatus status, const QString &message) const;
     ActionResponse makeActionFailure(std::uint64_t cmdId, CmdStatus status, const QString &message) const;
@@ -66,6 +83,10 @@ private:
     phicore::adapter::v1::Adapter m_runtimeAdapter;
     QJsonObject m_runtimeMeta;
     QJsonObject m_staticConfig;
+    // Parent of the timeout wheel's QTimer; declared first so it outlives it.
+    QObject m_timerContext;
+    phicore::adapter::Z2mTimerWheel m_timeouts{&m_timerContext};
+    QHash<std::uint64_t, PendingCommand> m_pendingCommands;
     bool m_started = false;
 };
 
@@ -4,13 +4,17 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonValue>
+#include <QMetaEnum>
+#include <QRandomGenerator>
 #include <QRegularExpression>
 #include <QSet>
 #include <QtGlobal>
 #include <QStringList>
 #include <algorithm>
+#include <utility>
 
 #include "mqttclient.h"
+#include "z2mjsonreader.h"
 
 namespace {
 
@@ -22,6 +26,19 @@ constexpr int kButtonMultiPressResetGapMs = 500;
 constexpr int kActionDuplicateWindowMs = 120;
 constexpr int kLongPressRepeatWindowMs = 800;
 constexpr int kDialDirectionCacheMs = 1500;
+constexpr qint64 kLastSeenReportIntervalMs = 60 * 1000;
+constexpr int kConfirmTimeoutMs = 5000;
+constexpr int kBridgeRequestTimeoutMs = 10000;
+// One timer wheel tick.
+constexpr int kCommandCoalesceMs = 10;
+// Sustained Zigbee frames per second handed to the coordinator.
+constexpr double kCommandRatePerSecond = 20.0;
+constexpr int kCommandBurst = 10;
+constexpr double kLatencySmoothing = 0.2;
+// Latency is a slow-moving diagnostic, unlike last_seen which drives
+// staleness in the UI; report it less often since every meta update
+// crosses IPC.
+constexpr qint64 kLatencyReportIntervalMs = 5 * 60 * 1000;
 
 phicore::adapter::ChannelFlags forceReadOnly(phicore::adapter::ChannelFlags flags)
 {
@@ -102,42 +119,14 @@ bool isKnownEnumName(const QString &name, const char *enumName)
     return name.compare(QString::fromLatin1(enumName), Qt::CaseInsensitive) == 0;
 }
 
-QSet<int> extractActionButtonIds(const QStringList &actions)
+QStringList actionTokens(const QString &normalizedAction)
 {
-    QSet<int> ids;
-    for (const QString &rawAction : actions) {
-        const QString action = rawAction.trimmed().toLower();
-        if (action.isEmpty())
-            continue;
-        const QStringList tokens = action.split(QRegularExpression(QStringLiteral("[^a-z0-9]+")),
-                                                Qt::SkipEmptyParts);
-        for (int i = 0; i < tokens.size(); ++i) {
-            const QString &token = tokens.at(i);
-            bool ok = false;
-            const int numeric = token.toInt(&ok);
-            if (ok && numeric > 0 && numeric <= 16) {
-                ids.insert(numeric);
-                break;
-            }
-            if (token == QStringLiteral("button") && i + 1 < tokens.size()) {
-                const int nextNumeric = tokens.at(i + 1).toInt(&ok);
-                if (ok && nextNumeric > 0 && nextNumeric <= 16) {
-                    ids.insert(nextNumeric);
-                    break;
-                }
-            }
-        }
-    }
-    return ids;
+    static const QRegularExpression separator(QStringLiteral("[^a-z0-9]+"));
+    return normalizedAction.split(separator, Qt::SkipEmptyParts);
 }
 
-int extractActionButtonId(const QString &rawAction)
+int actionButtonIdFromTokens(const QStringList &tokens)
 {
-    const QString action = rawAction.trimmed().toLower();
-    if (action.isEmpty())
-        return 0;
-    const QStringList tokens = action.split(QRegularExpression(QStringLiteral("[^a-z0-9]+")),
-                                            Qt::SkipEmptyParts);
     for (int i = 0; i < tokens.size(); ++i) {
         const QString &token = tokens.at(i);
         bool ok = false;
@@ -153,85 +142,49 @@ int extractActionButtonId(const QString &rawAction)
     return 0;
 }
 
-bool isDialAction(const QString &rawAction)
+bool isDialActionName(const QString &normalizedAction)
 {
-    const QString action = rawAction.trimmed().toLower();
-    if (action.isEmpty())
-        return false;
-    return action.contains(QStringLiteral("rotate"))
-        || action.contains(QStringLiteral("rotation"))
-        || action.contains(QStringLiteral("dial"))
-        || action.contains(QStringLiteral("brightness_step"))
-        || action.contains(QStringLiteral("brightness_move"));
+    return normalizedAction.contains(QStringLiteral("rotate"))
+        || normalizedAction.contains(QStringLiteral("rotation"))
+        || normalizedAction.contains(QStringLiteral("dial"))
+        || normalizedAction.contains(QStringLiteral("brightness_step"))
+        || normalizedAction.contains(QStringLiteral("brightness_move"));
 }
 
-int parseDialDelta(const QString &rawAction, const QJsonObject &payload)
+// Last non-zero number in the action name, or 0.
+int dialMagnitudeFromTokens(const QStringList &tokens)
 {
-    const QString action = rawAction.trimmed().toLower();
-    int magnitude = 1;
-    bool hasMagnitudeField = false;
-    bool magnitudeFromField = false;
-    const QStringList keys = {
-        QStringLiteral("action_step_size"),
-        QStringLiteral("action_step"),
-        QStringLiteral("step_size"),
-        QStringLiteral("step"),
-        QStringLiteral("rotation"),
-        QStringLiteral("angle")
-    };
-    for (const QString &key : keys) {
-        if (!payload.contains(key))
-            continue;
-        hasMagnitudeField = true;
-        bool ok = false;
-        const int parsed = qRound(payload.value(key).toDouble(0.0));
-        if (parsed != 0) {
-            magnitude = qAbs(parsed);
-            magnitudeFromField = true;
-            ok = true;
-        }
-        if (ok)
-            break;
-    }
-
-    const QStringList tokens = action.split(QRegularExpression(QStringLiteral("[^a-z0-9]+")),
-                                            Qt::SkipEmptyParts);
     for (int i = tokens.size() - 1; i >= 0; --i) {
         bool ok = false;
         const int parsed = tokens.at(i).toInt(&ok);
-        if (ok && parsed != 0) {
-            magnitude = qAbs(parsed);
-            break;
-        }
+        if (ok && parsed != 0)
+            return qAbs(parsed);
     }
+    return 0;
+}
 
-    if (hasMagnitudeField && !magnitudeFromField)
-        return 0;
-
-    if (action.contains(QStringLiteral("left"))
-        || action.contains(QStringLiteral("ccw"))
-        || action.contains(QStringLiteral("counterclockwise"))) {
-        return -magnitude;
+int dialDirectionFromTokens(const QStringList &tokens)
+{
+    if (tokens.contains(QStringLiteral("left"))
+        || tokens.contains(QStringLiteral("ccw"))
+        || tokens.contains(QStringLiteral("counterclockwise"))
+        || tokens.contains(QStringLiteral("down"))) {
+        return -1;
     }
-    if (action.contains(QStringLiteral("right"))
-        || action.contains(QStringLiteral("cw"))
-        || action.contains(QStringLiteral("clockwise"))) {
-        return magnitude;
+    if (tokens.contains(QStringLiteral("right"))
+        || tokens.contains(QStringLiteral("cw"))
+        || tokens.contains(QStringLiteral("clockwise"))
+        || tokens.contains(QStringLiteral("up"))) {
+        return 1;
     }
-    if (action.contains(QStringLiteral("_up")))
-        return magnitude;
-    if (action.contains(QStringLiteral("_down")))
-        return -magnitude;
     return 0;
 }
 
-int parseDialMagnitude(const QString &rawAction, const QJsonObject &payload)
+// Step size reported next to the action. Returns fallback if the payload
+// has none, and 0 if it has one that is zero (no movement).
+int dialMagnitudeFromPayload(const QJsonObject &payload, int fallback)
 {
-    const QString action = rawAction.trimmed().toLower();
-    int magnitude = 1;
-    bool hasMagnitudeField = false;
-    bool magnitudeFromField = false;
-    const QStringList keys = {
+    static const QStringList keys = {
         QStringLiteral("action_step_size"),
         QStringLiteral("action_step"),
         QStringLiteral("step_size"),
@@ -239,65 +192,29 @@ int parseDialMagnitude(const QString &rawAction, const QJsonObject &payload)
         QStringLiteral("rotation"),
         QStringLiteral("angle")
     };
+    bool hasMagnitudeField = false;
     for (const QString &key : keys) {
-        if (!payload.contains(key))
+        const auto it = payload.constFind(key);
+        if (it == payload.constEnd())
             continue;
         hasMagnitudeField = true;
-        const int parsed = qRound(payload.value(key).toDouble(0.0));
-        if (parsed != 0) {
-            magnitude = qAbs(parsed);
-            magnitudeFromField = true;
-            break;
-        }
-    }
-
-    if (hasMagnitudeField && !magnitudeFromField)
-        return 0;
-
-    const QStringList tokens = action.split(QRegularExpression(QStringLiteral("[^a-z0-9]+")),
-                                            Qt::SkipEmptyParts);
-    for (int i = tokens.size() - 1; i >= 0; --i) {
-        bool ok = false;
-        const int parsed = tokens.at(i).toInt(&ok);
-        if (ok && parsed != 0) {
-            magnitude = qAbs(parsed);
-            break;
-        }
+        const int parsed = qRound(it.value().toDouble(0.0));
+        if (parsed != 0)
+            return qAbs(parsed);
     }
-
-    return magnitude;
+    return hasMagnitudeField ? 0 : fallback;
 }
 
-int parseDialDirectionHint(const QString &rawAction, const QJsonObject &payload)
+int dialDirectionFromPayload(const QJsonObject &payload)
 {
-    const QString action = rawAction.trimmed().toLower();
-    const QStringList tokens = action.split(QRegularExpression(QStringLiteral("[^a-z0-9]+")),
-                                            Qt::SkipEmptyParts);
-    const auto hasToken = [&tokens](const QString &needle) {
-        return tokens.contains(needle);
-    };
-
-    if (hasToken(QStringLiteral("left"))
-        || hasToken(QStringLiteral("ccw"))
-        || hasToken(QStringLiteral("counterclockwise"))
-        || hasToken(QStringLiteral("down"))) {
+    const auto it = payload.constFind(QStringLiteral("action_direction"));
+    if (it == payload.constEnd())
+        return 0;
+    const int dir = it.value().toInt(0);
+    if (dir == 1)
         return -1;
-    }
-    if (hasToken(QStringLiteral("right"))
-        || hasToken(QStringLiteral("cw"))
-        || hasToken(QStringLiteral("clockwise"))
-        || hasToken(QStringLiteral("up"))) {
+    if (dir == 2)
         return 1;
-    }
-
-    if (payload.contains(QStringLiteral("action_direction"))) {
-        const int dir = payload.value(QStringLiteral("action_direction")).toInt(0);
-        if (dir == 1)
-            return -1;
-        if (dir == 2)
-            return 1;
-    }
-
     return 0;
 }
 
@@ -401,6 +318,43 @@ QStringList readStringList(const QJsonValue &value)
     return out;
 }
 
+// Parses "0x" followed by up to 16 hex digits (Z2M's ieee_address format)
+// without allocating. Returns 0 for anything else.
+quint64 parseIeeeAddress(QStringView text)
+{
+    if (text.size() < 3 || text.size() > 18 || text[0] != QLatin1Char('0')
+        || (text[1] != QLatin1Char('x') && text[1] != QLatin1Char('X')))
+        return 0;
+    quint64 value = 0;
+    for (const QChar c : text.sliced(2)) {
+        const char16_t u = c.unicode();
+        int digit;
+        if (u >= u'0' && u <= u'9')
+            digit = u - u'0';
+        else if (u >= u'a' && u <= u'f')
+            digit = u - u'a' + 10;
+        else if (u >= u'A' && u <= u'F')
+            digit = u - u'A' + 10;
+        else
+            return 0;
+        value = (value << 4) | static_cast<quint64>(digit);
+    }
+    return value;
+}
+
+QHash<QString, int> readIntervalMap(const QJsonObject &root, const QString &key)
+{
+    QHash<QString, int> out;
+    const QJsonObject obj = root.value(key).toObject();
+    for (auto it = obj.begin(); it != obj.end(); ++it) {
+        const QString mapKey = it.key().trimmed();
+        const int intervalMs = it.value().toInt(0);
+        if (!mapKey.isEmpty() && intervalMs > 0)
+            out.insert(mapKey, intervalMs);
+    }
+    return out;
+}
+
 QHash<QString, QStringList> readStringListMap(const QJsonObject &root, const QString &key)
 {
     QHash<QString, QStringList> out;
@@ -416,15 +370,110 @@ QHash<QString, QStringList> readStringListMap(const QJsonObject &root, const QSt
     return out;
 }
 
-bool startsWithAnyPrefix(const QString &property, const QStringList &prefixes)
+bool isAsciiSpace(char c)
 {
-    for (const QString &prefix : prefixes) {
-        if (prefix.isEmpty())
-            continue;
-        if (property.startsWith(prefix, Qt::CaseInsensitive))
-            return true;
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+QByteArrayView trimmedView(QByteArrayView text)
+{
+    qsizetype begin = 0;
+    qsizetype end = text.size();
+    while (begin < end && isAsciiSpace(text.at(begin)))
+        ++begin;
+    while (end > begin && isAsciiSpace(text.at(end - 1)))
+        --end;
+    return text.sliced(begin, end - begin);
+}
+
+bool equalsIgnoreCase(QByteArrayView text, QByteArrayView expected)
+{
+    return text.size() == expected.size()
+        && qstrnicmp(text.data(), text.size(), expected.data(), expected.size()) == 0;
+}
+
+phicore::adapter::ConnectivityStatus connectivityFromAvailability(QByteArrayView state)
+{
+    if (equalsIgnoreCase(state, "online"))
+        return phicore::adapter::ConnectivityStatus::Connected;
+    if (equalsIgnoreCase(state, "offline"))
+        return phicore::adapter::ConnectivityStatus::Disconnected;
+    return phicore::adapter::ConnectivityStatus::Unknown;
+}
+
+phicore::adapter::ConnectivityStatus connectivityFromAvailability(const QString &state)
+{
+    const QString trimmed = state.trimmed();
+    if (trimmed.compare(QLatin1String("online"), Qt::CaseInsensitive) == 0)
+        return phicore::adapter::ConnectivityStatus::Connected;
+    if (trimmed.compare(QLatin1String("offline"), Qt::CaseInsensitive) == 0)
+        return phicore::adapter::ConnectivityStatus::Disconnected;
+    return phicore::adapter::ConnectivityStatus::Unknown;
+}
+
+// Classifies and parses inbound messages on the MQTT worker thread so that
+// large payloads (bridge/devices) never block the adapter thread.
+::phicore::MqttClient::MessageDecoder makeMessageDecoder(
+    std::shared_ptr<const phicore::adapter::Z2mTopicRouter> router)
+{
+    using phicore::adapter::Z2mTopicRouter;
+    return [router = std::move(router)](::phicore::MqttMessage &message) {
+        const Z2mTopicRouter::Route route = router->route(message.topic());
+        message.setDecoded(static_cast<int>(route.topicClass),
+                           Z2mTopicRouter::decodePayload(route.topicClass, message.payload()),
+                           route.deviceId,
+                           route.device);
+    };
+}
+
+// Locates the device array in a bridge/devices payload (a bare array) or a
+// bridge/response/devices payload ({"data": [...]} or {"status": "ok",
+// "result": [...]}) without parsing it.
+QByteArrayView bridgeDevicesArray(QByteArrayView payload)
+{
+    const QByteArrayView trimmed = trimmedView(payload);
+    if (trimmed.startsWith('['))
+        return trimmed;
+    if (!trimmed.startsWith('{'))
+        return {};
+    const QByteArrayView data = phicore::adapter::z2mJsonObjectMember(trimmed, "data");
+    if (data.startsWith('['))
+        return data;
+    const QByteArrayView status = phicore::adapter::z2mJsonObjectMember(trimmed, "status");
+    if (!equalsIgnoreCase(status, "\"ok\""))
+        return {};
+    const QByteArrayView result = phicore::adapter::z2mJsonObjectMember(trimmed, "result");
+    return result.startsWith('[') ? result : QByteArrayView();
+}
+
+// Digest over every bridge/devices field buildDeviceEntry() reads. Volatile
+// fields (last_seen, network address) are left out so that a re-published
+// snapshot does not count as a change.
+size_t deviceDefinitionDigest(const QJsonObject &obj)
+{
+    static const QStringList keys = {
+        QStringLiteral("friendly_name"),
+        QStringLiteral("ieee_address"),
+        QStringLiteral("type"),
+        QStringLiteral("model_id"),
+        QStringLiteral("power_source"),
+        QStringLiteral("manufacturer"),
+        QStringLiteral("software_build_id"),
+        QStringLiteral("date_code"),
+        QStringLiteral("interview_completed"),
+        QStringLiteral("interviewing"),
+        QStringLiteral("supported"),
+        QStringLiteral("disabled"),
+        QStringLiteral("availability"),
+        QStringLiteral("definition"),
+    };
+    QJsonObject relevant;
+    for (const QString &key : keys) {
+        const auto it = obj.constFind(key);
+        if (it != obj.constEnd())
+            relevant.insert(key, it.value());
     }
-    return false;
+    return qHash(relevant);
 }
 
 }
@@ -433,7 +482,9 @@ namespace phicore::adapter {
 
 Z2mAdapter::Z2mAdapter(QObject *parent)
     : AdapterInterface(parent)
+    , m_timers(this)
 {
+    m_pacer.setRate(kCommandRatePerSecond, kCommandBurst);
 }
 
 Z2mAdapter::~Z2mAdapter()
@@ -463,14 +514,24 @@ bool Z2mAdapter::start(QString &errorString)
             updateConnectionState();
             scheduleReconnect();
         });
-        connect(m_client, &::phicore::MqttClient::messageReceived, this,
-                [this](const QByteArray &message, const QString &topic) {
-            handleMqttMessage(message, topic);
+        connect(m_client, &::phicore::MqttClient::messagesReceived, this,
+                [this](const QList<::phicore::MqttMessage> &messages) {
+            handleMqttMessages(messages);
+        });
+        connect(m_client, &::phicore::MqttClient::published, this,
+                [this](quint64 publishId, int messageId, int reasonCode) {
+            Q_UNUSED(messageId);
+            resolvePublish(publishId, reasonCode == 0);
+        });
+        connect(m_client, &::phicore::MqttClient::publishFailed, this, [this](quint64 publishId, int code) {
+            Q_UNUSED(code);
+            resolvePublish(publishId, false);
         });
         connect(m_client, &::phicore::MqttClient::errorOccurred, this, [this](int code, const QString &message) {
             if (m_client->state() == ::phicore::MqttClient::State::Connected)
                 return;
         });
+        rebuildTopicRouter();
     }
 
     if (adapter().ip.trimmed().isEmpty()) {
@@ -485,39 +546,45 @@ void Z2mAdapter::stop()
 {
     stopReconnectTimer();
     disconnectFromBroker();
-    for (auto it = m_postSetRefreshTimers.begin(); it != m_postSetRefreshTimers.end(); ++it) {
-        if (it.value()) {
-            it.value()->stop();
-            it.value()->deleteLater();
-        }
-    }
+    failBridgeRequests(CmdStatus::TemporarilyOffline, QStringLiteral("Adapter stopped"));
+    m_pacer.clear();
+    m_timers.clear();
     m_postSetRefreshTimers.clear();
-    for (auto it = m_dialResetTimers.begin(); it != m_dialResetTimers.end(); ++it) {
-        if (it.value()) {
-            it.value()->stop();
-            it.value()->deleteLater();
-        }
-    }
-    m_dialResetTimers.clear();
-    m_lastDialValueByChannel.clear();
-    m_pendingDialDirectionByChannel.clear();
-    m_pendingDialDirectionTsByChannel.clear();
-    m_recentActionTs.clear();
-    for (auto it = m_buttonMultiPressTimers.begin(); it != m_buttonMultiPressTimers.end(); ++it) {
-        if (it.value()) {
-            it.value()->stop();
-            it.value()->deleteLater();
-        }
-    }
-    m_buttonMultiPressTimers.clear();
-    m_buttonMultiPressCounts.clear();
-    m_buttonMultiPressLastTs.clear();
-    m_buttonLastEventCode.clear();
-    m_buttonLastEventTs.clear();
+    for (const Z2mCommandBatch &batch : std::exchange(m_commandBatches, {})) {
+        for (const ChannelWrite &write : batch.writes) {
+            CmdResponse response;
+            response.id = write.cmdId;
+            response.tsMs = QDateTime::currentMSecsSinceEpoch();
+            response.status = CmdStatus::TemporarilyOffline;
+            response.error = QStringLiteral("Adapter stopped before the command was sent");
+            emit cmdResult(response);
+        }
+    }
+    for (const CmdId cmdId : std::exchange(m_heldCommands, {})) {
+        CmdResponse response;
+        response.id = cmdId;
+        response.tsMs = QDateTime::currentMSecsSinceEpoch();
+        response.status = CmdStatus::TemporarilyOffline;
+        response.error = QStringLiteral("Adapter stopped before the device confirmed");
+        emit cmdResult(response);
+    }
+    // Drop transient channel state but keep the last emitted values.
+    m_devices.forEach([](DeviceHandle, Z2mDeviceEntry &entry) {
+        for (Z2mChannelRuntime &runtime : entry.channelRuntime) {
+            Z2mChannelRuntime reset;
+            reset.lastValue = std::move(runtime.lastValue);
+            reset.lastEmitMs = runtime.lastEmitMs;
+            runtime = std::move(reset);
+        }
+    });
+    const auto publishWaiters = std::exchange(m_publishWaiters, {});
+    for (const auto &done : publishWaiters)
+        done(false);
     if (m_client) {
         m_client->deleteLater();
         m_client = nullptr;
     }
+    m_subscribedTopics.clear();
     m_mqttConnected = false;
     updateConnectionState();
 }
@@ -533,16 +600,66 @@ void Z2mAdapter::adapterConfigUpdated()
 void Z2mAdapter::updateStaticConfig(const QJsonObject &config)
 {
     m_staticConfig = config;
-    m_suppressedPropertyPrefixes = readStringList(
-        config.value(QStringLiteral("suppressedPropertyPrefixes")));
-    m_suppressedPropertyPrefixesByModel = readStringListMap(
-        config, QStringLiteral("suppressedPropertyPrefixesByModel"));
-    m_suppressedPropertyPrefixesByModelId = readStringListMap(
-        config, QStringLiteral("suppressedPropertyPrefixesByModelId"));
-    m_allowedPropertyPrefixesByModel = readStringListMap(
-        config, QStringLiteral("allowedPropertyPrefixesByModel"));
-    m_allowedPropertyPrefixesByModelId = readStringListMap(
-        config, QStringLiteral("allowedPropertyPrefixesByModelId"));
+    m_propertyFilter = Z2mPropertyFilter(
+        readStringList(config.value(QStringLiteral("suppressedPropertyPrefixes"))),
+        readStringListMap(config, QStringLiteral("suppressedPropertyPrefixesByModel")),
+        readStringListMap(config, QStringLiteral("suppressedPropertyPrefixesByModelId")),
+        readStringListMap(config, QStringLiteral("allowedPropertyPrefixesByModel")),
+        readStringListMap(config, QStringLiteral("allowedPropertyPrefixesByModelId")));
+
+    // "channelDeadbands": {"Power": {"absolute": 1.0}, "Temperature": 0.05};
+    // keys are ChannelKind names, a bare number is an absolute deadband.
+    m_channelDeadbands.clear();
+    const QMetaEnum kindEnum = QMetaEnum::fromType<ChannelKind>();
+    const QJsonObject deadbands = config.value(QStringLiteral("channelDeadbands")).toObject();
+    for (auto it = deadbands.begin(); it != deadbands.end(); ++it) {
+        bool ok = false;
+        const int kind = kindEnum.keyToValue(it.key().trimmed().toLatin1().constData(), &ok);
+        if (!ok)
+            continue;
+        Z2mDeadband deadband;
+        if (it.value().isObject()) {
+            const QJsonObject obj = it.value().toObject();
+            deadband.absolute = obj.value(QStringLiteral("absolute")).toDouble(0.0);
+            deadband.relative = obj.value(QStringLiteral("relative")).toDouble(0.0);
+        } else {
+            deadband.absolute = it.value().toDouble(0.0);
+        }
+        if (deadband.absolute > 0.0 || deadband.relative > 0.0)
+            m_channelDeadbands.insert(kind, deadband);
+    }
+
+    // Minimum emit interval per channel kind, or for every channel of a
+    // model / model_id (which take precedence, model_id first).
+    m_minEmitIntervalMsByKind.clear();
+    const QHash<QString, int> intervalsByKind = readIntervalMap(
+        config, QStringLiteral("minEmitIntervalMsByKind"));
+    for (auto it = intervalsByKind.cbegin(); it != intervalsByKind.cend(); ++it) {
+        bool ok = false;
+        const int kind = kindEnum.keyToValue(it.key().toLatin1().constData(), &ok);
+        if (ok)
+            m_minEmitIntervalMsByKind.insert(kind, it.value());
+    }
+    m_confirmTimeoutMsByKind.clear();
+    const QHash<QString, int> confirmTimeoutsByKind = readIntervalMap(
+        config, QStringLiteral("confirmTimeoutMsByKind"));
+    for (auto it = confirmTimeoutsByKind.cbegin(); it != confirmTimeoutsByKind.cend(); ++it) {
+        bool ok = false;
+        const int kind = kindEnum.keyToValue(it.key().toLatin1().constData(), &ok);
+        if (ok)
+            m_confirmTimeoutMsByKind.insert(kind, it.value());
+    }
+    m_commandCoalesceMs = qMax(0, config.value(QStringLiteral("commandCoalesceMs")).toInt(kCommandCoalesceMs));
+    m_pacer.setRate(config.value(QStringLiteral("commandRatePerSecond")).toDouble(kCommandRatePerSecond),
+                    config.value(QStringLiteral("commandBurst")).toInt(kCommandBurst));
+    m_minEmitIntervalMsByModel = readIntervalMap(
+        config, QStringLiteral("minEmitIntervalMsByModel"));
+    m_minEmitIntervalMsByModelId = readIntervalMap(
+        config, QStringLiteral("minEmitIntervalMsByModelId"));
+    // Channel filtering depends on this config; force a rebuild of every
+    // device on the next bridge/devices snapshot.
+    m_devices.forEach([](DeviceHandle, Z2mDeviceEntry &entry) { entry.definitionDigest = 0; });
+    m_deviceTemplates.clear();
 }
 
 void Z2mAdapter::requestFullSync()
@@ -552,10 +669,24 @@ void Z2mAdapter::requestFullSync()
         const QString topic = QStringLiteral("%1/bridge/request/devices").arg(m_baseTopic);
         m_client->publish(topic, requestPayload);
     }
-    if (!m_devices.isEmpty()) {
-        for (auto it = m_devices.constBegin(); it != m_devices.constEnd(); ++it) {
-            emit deviceUpdated(it.value().device, it.value().channels);
+    m_devices.forEach([this](DeviceHandle, Z2mDeviceEntry &entry) {
+        emit deviceUpdated(entry.device, entry.deviceTemplate->channels);
+        // Full sync bypasses change suppression: replay every cached value.
+        const qint64 tsMs = QDateTime::currentMSecsSinceEpoch();
+        for (const Z2mChannelBinding &binding : entry.deviceTemplate->bindingsByChannel) {
+            const QVariant cached = entry.channelRuntime[binding.index].lastValue;
+            if (cached.isValid())
+                emitChannelState(entry, binding, cached, tsMs, true);
         }
+    });
+    for (const Z2mGroupEntry &group : std::as_const(m_groups))
+        emit groupUpdated(group.group);
+    if (!m_scenes.isEmpty()) {
+        QList<Scene> scenes;
+        scenes.reserve(m_scenes.size());
+        for (const Z2mSceneEntry &scene : std::as_const(m_scenes))
+            scenes.append(scene.scene);
+        emit scenesUpdated(scenes);
     }
 }
 
@@ -563,27 +694,71 @@ void Z2mAdapter::updateChannelState(const QString &deviceExternalId,
                                     const QString &channelExternalId,
                                     const QVariant &value,
                                     CmdId cmdId)
+{
+    if (!findDeviceByExternalId(deviceExternalId)) {
+        const auto groupIt = m_groups.constFind(deviceExternalId);
+        if (groupIt != m_groups.cend()) {
+            updateGroupChannelState(groupIt.value(), channelExternalId, value, cmdId);
+            return;
+        }
+    }
+
+    ChannelWrite write;
+    write.channelExternalId = channelExternalId;
+    write.value = value;
+    write.cmdId = cmdId;
+    const QString key = queueChannelWrite(deviceExternalId, write);
+    if (key.isEmpty())
+        return;
+    if (m_commandCoalesceMs <= 0) {
+        releaseCommandBatch(key);
+        return;
+    }
+    // Core sends a multi-channel change (scene, state + brightness) as
+    // separate invokes; hold the first briefly so the rest join its /set.
+    Z2mCommandBatch &batch = m_commandBatches[key];
+    if (!batch.flushTimer && !batch.queued)
+        batch.flushTimer = m_timers.schedule(m_commandCoalesceMs, [this, key]() { releaseCommandBatch(key); });
+}
+
+void Z2mAdapter::updateChannelStates(const QString &deviceExternalId, const QList<ChannelWrite> &writes)
+{
+    if (!findDeviceByExternalId(deviceExternalId) && m_groups.contains(deviceExternalId)) {
+        AdapterInterface::updateChannelStates(deviceExternalId, writes);
+        return;
+    }
+    QStringList keys;
+    for (const ChannelWrite &write : writes) {
+        const QString key = queueChannelWrite(deviceExternalId, write);
+        if (!key.isEmpty() && !keys.contains(key))
+            keys.append(key);
+    }
+    // Already complete; earlier single writes waiting in the same batch go
+    // out with it.
+    for (const QString &key : std::as_const(keys))
+        releaseCommandBatch(key);
+}
+
+QString Z2mAdapter::queueChannelWrite(const QString &deviceExternalId, const ChannelWrite &write)
 {
     CmdResponse response;
-    response.id = cmdId;
+    response.id = write.cmdId;
     response.tsMs = QDateTime::currentMSecsSinceEpoch();
 
-    const QString mqttId = m_mqttByExternal.value(deviceExternalId, deviceExternalId);
-    const auto deviceIt = m_devices.find(mqttId);
-    if (deviceIt == m_devices.end()) {
+    const Z2mDeviceEntry *entry = findDeviceByExternalId(deviceExternalId);
+    if (!entry) {
         response.status = CmdStatus::NotSupported;
         response.error = QStringLiteral("Unknown device");
         emit cmdResult(response);
-        return;
+        return {};
     }
 
-    const Z2mDeviceEntry &entry = deviceIt.value();
-    const auto bindingIt = entry.bindingsByChannel.find(channelExternalId);
-    if (bindingIt == entry.bindingsByChannel.end()) {
+    const auto bindingIt = entry->deviceTemplate->bindingsByChannel.constFind(write.channelExternalId);
+    if (bindingIt == entry->deviceTemplate->bindingsByChannel.cend()) {
         response.status = CmdStatus::NotSupported;
         response.error = QStringLiteral("Unknown channel");
         emit cmdResult(response);
-        return;
+        return {};
     }
 
     const Z2mChannelBinding &binding = bindingIt.value();
@@ -591,58 +766,178 @@ void Z2mAdapter::updateChannelState(const QString &deviceExternalId,
         response.status = CmdStatus::NotSupported;
         response.error = QStringLiteral("Channel is read-only");
         emit cmdResult(response);
-        return;
+        return {};
     }
 
     if (!m_connected || !m_client || m_client->state() != ::phicore::MqttClient::State::Connected) {
         response.status = CmdStatus::TemporarilyOffline;
         response.error = QStringLiteral("MQTT broker not connected");
         emit cmdResult(response);
-        return;
+        return {};
     }
 
     QJsonObject payload;
     QString errorString;
-    if (!buildCommandPayload(deviceExternalId, binding, value, payload, errorString)) {
+    if (!buildCommandPayload(deviceExternalId, binding, write.value, payload, errorString)) {
         response.status = CmdStatus::InvalidArgument;
         response.error = errorString;
         emit cmdResult(response);
+        return {};
+    }
+
+    const QString key = entry->device.id + QLatin1Char('\n') + binding.endpoint;
+    Z2mCommandBatch &batch = m_commandBatches[key];
+    batch.externalId = entry->device.id;
+    batch.endpoint = binding.endpoint;
+    // A later write of the same property wins. The earlier write's value is
+    // never sent, so it is reported as superseded instead of riding on the
+    // merged payload's delivery.
+    for (auto it = payload.begin(); it != payload.end(); ++it) {
+        const QJsonValue value = it.value();
+        if (batch.payload.contains(it.key()) && batch.payload.value(it.key()) != value) {
+            const CmdId overwritten = batch.ownerByProperty.value(it.key());
+            const auto writeIt = std::find_if(batch.writes.begin(), batch.writes.end(),
+                                              [overwritten](const ChannelWrite &queued) {
+                                                  return queued.cmdId == overwritten;
+                                              });
+            if (overwritten != 0 && writeIt != batch.writes.end()) {
+                batch.writes.erase(writeIt);
+                CmdResponse superseded;
+                superseded.id = overwritten;
+                superseded.tsMs = response.tsMs;
+                superseded.status = CmdStatus::Failure;
+                superseded.error = QStringLiteral("Superseded by a newer command before it was sent");
+                emit cmdResult(superseded);
+            }
+        }
+        batch.payload.insert(it.key(), value);
+        batch.ownerByProperty.insert(it.key(), write.cmdId);
+    }
+    batch.writes.append(write);
+    return key;
+}
+
+void Z2mAdapter::releaseCommandBatch(const QString &key)
+{
+    const auto batchIt = m_commandBatches.find(key);
+    if (batchIt == m_commandBatches.end() || batchIt->queued)
+        return;
+    m_timers.cancel(std::exchange(batchIt->flushTimer, 0));
+    batchIt->queued = true;
+    // Dropped jobs need no report here: stop() reports every batch left.
+    const QString externalId = batchIt->externalId;
+    m_pacer.enqueue(externalId, Z2mCommandPacer::Priority::Command, [this, key](bool send) {
+        if (send)
+            flushCommandBatch(key);
+    });
+}
+
+void Z2mAdapter::flushCommandBatch(const QString &key)
+{
+    auto batchIt = m_commandBatches.find(key);
+    if (batchIt == m_commandBatches.end())
+        return;
+    Z2mCommandBatch batch = std::move(batchIt.value());
+    m_commandBatches.erase(batchIt);
+    m_timers.cancel(batch.flushTimer);
+
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    auto failAll = [this, &batch, nowMs](CmdStatus status, const QString &error) {
+        for (const ChannelWrite &write : std::as_const(batch.writes)) {
+            CmdResponse response;
+            response.id = write.cmdId;
+            response.tsMs = nowMs;
+            response.status = status;
+            response.error = error;
+            emit cmdResult(response);
+        }
+    };
+
+    // The device may have been removed or renamed within the window.
+    Z2mDeviceEntry *device = findDeviceByExternalId(batch.externalId);
+    if (!device) {
+        failAll(CmdStatus::NotSupported, QStringLiteral("Unknown device"));
         return;
     }
+    Z2mDeviceEntry &entry = *device;
+    const QString mqttId = entry.mqttId;
 
-    if (!publishCommand(mqttId, payload, binding.endpoint, errorString)) {
-        response.status = CmdStatus::Failure;
-        response.error = errorString;
-        emit cmdResult(response);
+    QString errorString;
+    const ::phicore::MqttClient::PublishId publishId =
+        publishCommand(mqttId, batch.payload, batch.endpoint, errorString);
+    if (!publishId) {
+        failAll(CmdStatus::Failure, errorString);
         return;
     }
 
-    if (binding.kind == ChannelKind::ColorRGB) {
-        phicore::adapter::Color color;
-        if (colorFromVariant(value, &color))
-            emit channelStateUpdated(deviceExternalId, binding.channelId, QVariant::fromValue(color), QDateTime::currentMSecsSinceEpoch());
-    }
-
-    // Debounced post-set refresh to read back all reported channels.
-    QTimer *refreshTimer = m_postSetRefreshTimers.value(mqttId);
-    if (!refreshTimer) {
-        refreshTimer = new QTimer(this);
-        refreshTimer->setSingleShot(true);
-        m_postSetRefreshTimers.insert(mqttId, refreshTimer);
-        connect(refreshTimer, &QTimer::timeout, this, [this, mqttId]() {
-            if (!m_client || m_client->state() != ::phicore::MqttClient::State::Connected)
+    struct Sent {
+        CmdId cmdId = 0;
+        QString channelId;
+        bool confirm = false;
+    };
+    QList<Sent> sent;
+    sent.reserve(batch.writes.size());
+    for (const ChannelWrite &write : std::as_const(batch.writes)) {
+        Sent item;
+        item.cmdId = write.cmdId;
+        item.channelId = write.channelExternalId;
+        const auto bindingIt = entry.deviceTemplate->bindingsByChannel.constFind(write.channelExternalId);
+        if (bindingIt != entry.deviceTemplate->bindingsByChannel.cend()) {
+            const Z2mChannelBinding &binding = bindingIt.value();
+            // Only channels that report state can be confirmed by their echo.
+            item.confirm = m_confirmCommands && binding.flags.testFlag(ChannelFlag::ChannelFlagReportable);
+            if (item.confirm)
+                beginStateConfirmation(entry, binding, write.value, write.cmdId, nowMs);
+            if (binding.kind == ChannelKind::ColorRGB) {
+                phicore::adapter::Color color;
+                if (colorFromVariant(write.value, &color))
+                    emitChannelState(entry, binding, QVariant::fromValue(color), nowMs);
+            }
+        }
+        sent.append(item);
+    }
+
+    // Debounced post-set refresh to read back all reported channels; it
+    // queues behind every pending command.
+    m_timers.cancel(m_postSetRefreshTimers.value(mqttId));
+    m_postSetRefreshTimers.insert(mqttId, m_timers.schedule(1000, [this, mqttId, externalId = entry.device.id]() {
+        m_postSetRefreshTimers.remove(mqttId);
+        m_pacer.enqueue(externalId, Z2mCommandPacer::Priority::Refresh, [this, mqttId](bool send) {
+            if (!send || !m_client || m_client->state() != ::phicore::MqttClient::State::Connected)
                 return;
             const QString topic = QStringLiteral("%1/%2/get").arg(m_baseTopic, mqttId);
-            const qint32 msgId = m_client->publish(topic, QByteArrayLiteral("{}"));
-            if (msgId < 0) {
+            m_client->publish(topic, QByteArrayLiteral("{}"));
+        });
+    }));
+
+    // Report once mosquitto has handed the message to the broker; confirmed
+    // commands are reported by confirmChannelState() instead.
+    awaitPublish(publishId, [this, sent, externalId = entry.device.id](bool ok) {
+        for (const Sent &item : sent) {
+            if (item.confirm && (ok || !cancelStateConfirmation(externalId, item.channelId, item.cmdId)))
+                continue;
+            CmdResponse response;
+            response.id = item.cmdId;
+            response.tsMs = QDateTime::currentMSecsSinceEpoch();
+            if (ok) {
+                response.status = CmdStatus::Success;
             } else {
+                response.status = CmdStatus::Failure;
+                response.error = QStringLiteral("MQTT publish failed.");
             }
-        });
-    }
-    refreshTimer->start(1000);
+            emit cmdResult(response);
+        }
+    });
+}
 
-    response.status = CmdStatus::Success;
-    emit cmdResult(response);
+bool Z2mAdapter::deviceSnapshot(const QString &deviceExternalId, Device &device, ChannelList &channels)
+{
+    const Z2mDeviceEntry *entry = findDeviceByExternalId(deviceExternalId);
+    if (!entry || !entry->deviceTemplate)
+        return false;
+    device = entry->device;
+    channels = entry->deviceTemplate->channels;
+    return true;
 }
 
 void Z2mAdapter::updateDeviceName(const QString &deviceId, const QString &name, CmdId cmdId)
@@ -659,7 +954,8 @@ void Z2mAdapter::updateDeviceName(const QString &deviceId, const QString &name,
         return;
     }
 
-    const QString mqttId = m_mqttByExternal.value(deviceId, deviceId);
+    const Z2mDeviceEntry *entry = findDeviceByExternalId(deviceId);
+    const QString mqttId = entry ? entry->mqttId : deviceId;
     if (mqttId.isEmpty()) {
         response.status = CmdStatus::NotSupported;
         response.error = QStringLiteral("Unknown device");
@@ -680,35 +976,95 @@ void Z2mAdapter::updateDeviceName(const QString &deviceId, const QString &name,
         return;
     }
 
+    PendingRename pending;
+    pending.cmdId = cmdId;
+    pending.targetName = trimmed;
+    m_pendingRename.insert(deviceId, pending);
+
     QJsonObject payload;
     payload.insert(QStringLiteral("from"), mqttId);
     payload.insert(QStringLiteral("to"), trimmed);
-    const QString topic = QStringLiteral("%1/bridge/request/device/rename").arg(m_baseTopic);
-    const qint32 msgId = m_client->publish(topic, QJsonDocument(payload).toJson(QJsonDocument::Compact));
-    if (msgId < 0) {
-        response.status = CmdStatus::Failure;
-        response.error = QStringLiteral("MQTT publish failed.");
+    const QString transaction = bridgeRequest(
+        QStringLiteral("device/rename"), payload,
+        [this, deviceId, cmdId](CmdStatus status, const QJsonObject &, const QString &error) {
+            const auto it = m_pendingRename.constFind(deviceId);
+            if (it != m_pendingRename.cend() && it.value().cmdId == cmdId)
+                m_pendingRename.erase(it);
+            CmdResponse done;
+            done.id = cmdId;
+            done.tsMs = QDateTime::currentMSecsSinceEpoch();
+            done.status = status;
+            done.error = error;
+            if (status == CmdStatus::Success) {
+                if (Z2mDeviceEntry *renamed = findDeviceByExternalId(deviceId)) {
+                    for (const Z2mChannelBinding &binding : renamed->deviceTemplate->bindingsByChannel) {
+                        if (!binding.isAvailability)
+                            continue;
+                        emitChannelState(*renamed, binding,
+                                         static_cast<int>(ConnectivityStatus::Connected),
+                                         done.tsMs);
+                        break;
+                    }
+                }
+            }
+            emit cmdResult(done);
+        });
+    // Empty if the request already failed and was reported.
+    const auto it = m_pendingRename.find(deviceId);
+    if (it != m_pendingRename.end() && it.value().cmdId == cmdId)
+        it.value().transaction = transaction;
+}
+
+void Z2mAdapter::invokeScene(const QString &sceneExternalId,
+                             const QString &groupExternalId,
+                             const QString &action,
+                             CmdId cmdId)
+{
+    // The scene id already names the group or device it is stored on.
+    Q_UNUSED(groupExternalId);
+    CmdResponse response;
+    response.id = cmdId;
+    response.tsMs = QDateTime::currentMSecsSinceEpoch();
+
+    if (!action.isEmpty() && action.compare(QStringLiteral("activate"), Qt::CaseInsensitive) != 0) {
+        response.status = CmdStatus::NotSupported;
+        response.error = QStringLiteral("Only scene activation is supported");
         emit cmdResult(response);
         return;
     }
 
-    PendingRename pending;
-    pending.cmdId = cmdId;
-    pending.targetName = trimmed;
-    pending.requestedAtMs = response.tsMs;
-    m_pendingRename.insert(deviceId, pending);
-    QTimer::singleShot(10000, this, [this, deviceId]() {
-        const auto it = m_pendingRename.constFind(deviceId);
-        if (it == m_pendingRename.constEnd())
-            return;
-        CmdResponse timeoutResp;
-        timeoutResp.id = it.value().cmdId;
-        timeoutResp.tsMs = QDateTime::currentMSecsSinceEpoch();
-        timeoutResp.status = CmdStatus::Failure;
-        timeoutResp.error = QStringLiteral("Rename timeout");
-        emit cmdResult(timeoutResp);
-        m_pendingRename.remove(deviceId);
-    });
+    const auto sceneIt = m_scenes.constFind(sceneExternalId);
+    if (sceneIt == m_scenes.cend()) {
+        response.status = CmdStatus::NotSupported;
+        response.error = QStringLiteral("Unknown scene");
+        emit cmdResult(response);
+        return;
+    }
+    const Z2mSceneEntry &scene = sceneIt.value();
+    QString mqttId;
+    if (const auto groupIt = m_groups.constFind(scene.targetId); groupIt != m_groups.cend()) {
+        mqttId = groupIt->mqttId;
+    } else if (const Z2mDeviceEntry *device = findDeviceByExternalId(scene.targetId)) {
+        mqttId = device->mqttId;
+    } else {
+        response.status = CmdStatus::NotSupported;
+        response.error = QStringLiteral("Scene target no longer exists");
+        emit cmdResult(response);
+        return;
+    }
+
+    if (!m_connected || !m_client || m_client->state() != ::phicore::MqttClient::State::Connected) {
+        response.status = CmdStatus::TemporarilyOffline;
+        response.error = QStringLiteral("MQTT broker not connected");
+        emit cmdResult(response);
+        return;
+    }
+
+    // A stored Zigbee scene is recalled with a single frame; members
+    // publish their resulting state on their own.
+    QJsonObject payload;
+    payload.insert(QStringLiteral("scene_recall"), scene.z2mSceneId);
+    publishPacedCommand(scene.targetId, mqttId, payload, scene.endpoint, response);
 }
 
 void Z2mAdapter::invokeAdapterAction(const QString &actionId,
@@ -749,8 +1105,9 @@ void Z2mAdapter::invokeAdapterAction(const QString &actionId,
             return;
         }
 
-        const QString mqttId = m_mqttByExternal.value(externalId, externalId);
-        if (!m_devices.contains(mqttId)) {
+        const DeviceHandle handle = deviceHandleFor(externalId);
+        const Z2mDeviceEntry *entry = m_devices.get(handle);
+        if (!entry) {
             resp.status = CmdStatus::InvalidArgument;
             resp.error = QStringLiteral("Device not found.");
             emit actionResult(resp);
@@ -758,45 +1115,44 @@ void Z2mAdapter::invokeAdapterAction(const QString &actionId,
         }
 
         QJsonObject payload;
-        payload.insert(QStringLiteral("id"), mqttId);
-        const QString topic = QStringLiteral("%1/bridge/request/device/remove").arg(m_baseTopic);
-        const qint32 msgId = m_client->publish(topic,
-                                               QJsonDocument(payload).toJson(QJsonDocument::Compact));
-        if (msgId < 0) {
-            resp.status = CmdStatus::Failure;
-            resp.error = QStringLiteral("MQTT publish failed.");
+        payload.insert(QStringLiteral("id"), entry->mqttId);
+        bridgeRequest(QStringLiteral("device/remove"), payload,
+                      [this, resp, externalId, handle](CmdStatus status, const QJsonObject &,
+                                                        const QString &error) mutable {
+            resp.tsMs = QDateTime::currentMSecsSinceEpoch();
+            if (status != CmdStatus::Success) {
+                resp.status = status;
+                resp.error = error;
+                emit actionResult(resp);
+                return;
+            }
+            emit deviceRemoved(externalId);
+            if (m_devices.contains(handle)) {
+                removeDevice(handle);
+                rebuildTopicRouter();
+            }
+            resp.status = CmdStatus::Success;
             emit actionResult(resp);
-            return;
-        }
-
-        emit deviceRemoved(externalId);
-        m_mqttByExternal.remove(externalId);
-        m_devices.remove(mqttId);
-        resp.status = CmdStatus::Success;
-        emit actionResult(resp);
+        });
         return;
     }
 
     QJsonObject payload;
-    QString topic;
+    QString request;
     if (actionId == QStringLiteral("restartZ2M")) {
-        topic = QStringLiteral("%1/bridge/request/restart").arg(m_baseTopic);
+        request = QStringLiteral("restart");
     } else {
         payload.insert(QStringLiteral("value"), true);
         payload.insert(QStringLiteral("time"), 120);
-        topic = QStringLiteral("%1/bridge/request/permit_join").arg(m_baseTopic);
+        request = QStringLiteral("permit_join");
     }
-    const qint32 msgId = m_client->publish(topic,
-                                           QJsonDocument(payload).toJson(QJsonDocument::Compact));
-    if (msgId < 0) {
-        resp.status = CmdStatus::Failure;
-        resp.error = QStringLiteral("MQTT publish failed.");
+    bridgeRequest(request, payload,
+                  [this, resp](CmdStatus status, const QJsonObject &, const QString &error) mutable {
+        resp.tsMs = QDateTime::currentMSecsSinceEpoch();
+        resp.status = status;
+        resp.error = error;
         emit actionResult(resp);
-        return;
-    }
-
-    resp.status = CmdStatus::Success;
-    emit actionResult(resp);
+    });
 }
 
 void Z2mAdapter::setConnected(bool connected, bool forceNotify)
@@ -816,7 +1172,7 @@ void Z2mAdapter::updateConnectionState(bool forceNotify)
 
 void Z2mAdapter::scheduleConnectionStateRefresh()
 {
-    QTimer::singleShot(1500, this, [this]() {
+    m_timers.schedule(1500, [this]() {
         updateConnectionState(true);
     });
 }
@@ -825,6 +1181,7 @@ void Z2mAdapter::applyConfig()
 {
     const int retry = adapter().meta.value(QStringLiteral("retryIntervalMs")).toInt(10000);
     m_retryIntervalMs = retry >= 1000 ? retry : 10000;
+    m_confirmCommands = adapter().meta.value(QStringLiteral("confirmCommands")).toBool(false);
 
     const QString baseTopic = adapter().meta.value(QStringLiteral("baseTopic")).toString().trimmed();
     if (!baseTopic.isEmpty())
@@ -833,6 +1190,9 @@ void Z2mAdapter::applyConfig()
         m_baseTopic = QStringLiteral("zigbee2mqtt");
     if (m_baseTopic.endsWith(QLatin1Char('/')))
         m_baseTopic.chop(1);
+    const QByteArray topicPrefix = m_baseTopic.toUtf8() + '/';
+    if (!m_topicRouter || m_topicRouter->topicPrefix() != topicPrefix)
+        rebuildTopicRouter();
 
     if (!m_client)
         return;
@@ -845,6 +1205,14 @@ void Z2mAdapter::applyConfig()
     m_client->setPassword(adapter().pw);
 }
 
+void Z2mAdapter::rebuildTopicRouter()
+{
+    m_topicRouter = std::make_shared<const Z2mTopicRouter>(m_baseTopic.toUtf8() + '/', m_deviceByName);
+    if (m_client)
+        m_client->setMessageDecoder(makeMessageDecoder(m_topicRouter));
+    syncSubscriptions();
+}
+
 void Z2mAdapter::connectToBroker()
 {
     if (!m_client)
@@ -891,421 +1259,434 @@ void Z2mAdapter::stopReconnectTimer()
 
 void Z2mAdapter::ensureSubscriptions()
 {
-    if (!m_client || m_client->state() != ::phicore::MqttClient::State::Connected)
-        return;
-    m_client->subscribe(QStringLiteral("%1/#").arg(m_baseTopic));
+    // Called on (re)connect: the broker may have dropped our session, so
+    // replay the full plan instead of diffing against stale state.
+    m_subscribedTopics.clear();
+    syncSubscriptions();
 }
 
-void Z2mAdapter::handleMqttMessage(const QByteArray &message, const QString &topic)
+QSet<QString> Z2mAdapter::plannedSubscriptions() const
 {
+    static const QStringList bridgeTopics = {
+        QStringLiteral("bridge/state"),
+        QStringLiteral("bridge/info"),
+        QStringLiteral("bridge/devices"),
+        QStringLiteral("bridge/health"),
+        QStringLiteral("bridge/event"),
+        QStringLiteral("bridge/groups"),
+        QStringLiteral("bridge/response/#"),
+    };
+    QSet<QString> topics;
+    topics.reserve(bridgeTopics.size() + m_devices.size() * 3);
     const QString prefix = m_baseTopic + QLatin1Char('/');
-    if (!topic.startsWith(prefix))
+    for (const QString &topic : bridgeTopics)
+        topics.insert(prefix + topic);
+    for (auto it = m_deviceByName.cbegin(); it != m_deviceByName.cend(); ++it) {
+        const QString &mqttId = it.key();
+        // Wildcards would widen the filter; Z2M rejects such names anyway.
+        if (mqttId.isEmpty() || mqttId.contains(QLatin1Char('+')) || mqttId.contains(QLatin1Char('#')))
+            continue;
+        topics.insert(prefix + mqttId);
+        topics.insert(prefix + mqttId + QStringLiteral("/availability"));
+        topics.insert(prefix + mqttId + QStringLiteral("/action"));
+    }
+    return topics;
+}
+
+void Z2mAdapter::syncSubscriptions()
+{
+    if (!m_client || m_client->state() != ::phicore::MqttClient::State::Connected)
         return;
-    const QString suffix = topic.mid(prefix.size());
+    const QSet<QString> planned = plannedSubscriptions();
+    for (const QString &topic : std::as_const(m_subscribedTopics)) {
+        if (!planned.contains(topic))
+            m_client->unsubscribe(topic);
+    }
+    for (const QString &topic : planned) {
+        if (!m_subscribedTopics.contains(topic))
+            m_client->subscribe(topic);
+    }
+    m_subscribedTopics = planned;
+}
 
-    if (suffix.startsWith(QStringLiteral("bridge/"))) {
-        if (suffix == QStringLiteral("bridge/state")) {
-            const QString payloadText = QString::fromUtf8(message).trimmed().toLower();
-            if (payloadText == QStringLiteral("{\"state\":\"offline\"}")
-                || payloadText == QStringLiteral("offline")) {
-                m_bridgeOnline = false;
-                updateConnectionState();
-                return;
-            }
-            if (payloadText == QStringLiteral("{\"state\":\"online\"}")
-                || payloadText == QStringLiteral("online")) {
-                m_bridgeOnline = true;
-                updateConnectionState();
-                if (!m_lastSeenRequested) {
-                    QJsonObject advanced;
-                    advanced.insert(QStringLiteral("last_seen"), QStringLiteral("epoch"));
-                    QJsonObject options;
-                    options.insert(QStringLiteral("advanced"), advanced);
-                    QJsonObject payload;
-                    payload.insert(QStringLiteral("options"), options);
-                    const QString topic = QStringLiteral("%1/bridge/request/options").arg(m_baseTopic);
-                    m_client->publish(topic,
-                                      QJsonDocument(payload).toJson(QJsonDocument::Compact));
-                    m_lastSeenRequested = true;
-                }
-                return;
-            }
-        }
-        if (suffix == QStringLiteral("bridge/health")) {
-            QJsonParseError err;
-            const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-            if (err.error != QJsonParseError::NoError || !doc.isObject()) {
-                return;
-            }
-            QJsonObject metaPatch;
-            metaPatch.insert(QStringLiteral("health"), doc.object());
-            emit adapterMetaUpdated(metaPatch);
+void Z2mAdapter::handleMqttMessages(const QList<::phicore::MqttMessage> &messages)
+{
+    for (const ::phicore::MqttMessage &message : messages) {
+        handleMqttMessage(message);
+        // stop() may run from a handler (e.g. via a signal into the host).
+        if (!m_client)
             return;
-        }
-        if (suffix == QStringLiteral("bridge/response/device/rename")) {
-            QJsonParseError err;
-            const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-            if (err.error != QJsonParseError::NoError || !doc.isObject()) {
-                return;
-            }
-            const QJsonObject resp = doc.object();
-            const QJsonObject data = resp.value(QStringLiteral("data")).toObject();
-            const QString status = resp.value(QStringLiteral("status")).toString().trimmed().toLower();
-            const QString from = data.value(QStringLiteral("from")).toString().trimmed();
-            const QString to = data.value(QStringLiteral("to")).toString().trimmed();
-            if (status == QStringLiteral("ok")) {
-                auto it = m_pendingRename.begin();
-                while (it != m_pendingRename.end()) {
-                    const QString ieee = it.key();
-                    const QString currentMqtt = m_mqttByExternal.value(ieee);
-                    if ((!to.isEmpty() && it.value().targetName == to)
-                        || (!from.isEmpty() && currentMqtt == from)) {
-                        CmdResponse response;
-                        response.id = it.value().cmdId;
-                        response.tsMs = QDateTime::currentMSecsSinceEpoch();
-                        response.status = CmdStatus::Success;
-                        emit cmdResult(response);
-                        it = m_pendingRename.erase(it);
-                        const QString mqttId = !to.isEmpty() ? to : currentMqtt;
-                        const auto entryIt = m_devices.find(mqttId);
-                        if (entryIt != m_devices.end()) {
-                            for (auto bindIt = entryIt.value().bindingsByChannel.begin();
-                                 bindIt != entryIt.value().bindingsByChannel.end();
-                                 ++bindIt) {
-                                if (!bindIt.value().isAvailability)
-                                    continue;
-                                emit channelStateUpdated(entryIt.value().device.id,
-                                                         bindIt.value().channelId,
-                                                         static_cast<int>(ConnectivityStatus::Connected),
-                                                         QDateTime::currentMSecsSinceEpoch());
-                                break;
-                            }
-                        }
-                        continue;
-                    }
-                    ++it;
-                }
-            }
+    }
+}
+
+void Z2mAdapter::handleMqttMessage(const ::phicore::MqttMessage &mqttMessage)
+{
+    // Messages normally arrive routed and parsed by the worker thread. A
+    // route from a router snapshot replaced in the meantime carries at
+    // worst a stale handle, which the handlers resolve by friendly name.
+    Z2mTopicRouter::Route route;
+    QJsonDocument doc;
+    if (mqttMessage.isDecoded()) {
+        route.topicClass = static_cast<Z2mTopicClass>(mqttMessage.tag());
+        route.deviceId = mqttMessage.subject();
+        route.device = mqttMessage.handle();
+        doc = mqttMessage.document();
+    } else {
+        if (!m_topicRouter)
+            rebuildTopicRouter();
+        route = m_topicRouter->route(mqttMessage.topic());
+        doc = Z2mTopicRouter::decodePayload(route.topicClass, mqttMessage.payload());
+    }
+    const Z2mTopicClass topicClass = route.topicClass;
+
+    switch (topicClass) {
+    case Z2mTopicClass::Unhandled:
+        return;
+    case Z2mTopicClass::BridgeState: {
+        const QByteArrayView payloadText = trimmedView(mqttMessage.payload());
+        if (equalsIgnoreCase(payloadText, "{\"state\":\"offline\"}")
+            || equalsIgnoreCase(payloadText, "offline")) {
+            m_bridgeOnline = false;
+            updateConnectionState();
             return;
         }
-        if (suffix == QStringLiteral("bridge/response/options")) {
-            QJsonParseError err;
-            const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-            if (err.error != QJsonParseError::NoError || !doc.isObject()) {
-                return;
+        if (equalsIgnoreCase(payloadText, "{\"state\":\"online\"}")
+            || equalsIgnoreCase(payloadText, "online")) {
+            m_bridgeOnline = true;
+            updateConnectionState();
+            if (!m_lastSeenRequested) {
+                QJsonObject advanced;
+                advanced.insert(QStringLiteral("last_seen"), QStringLiteral("epoch"));
+                QJsonObject options;
+                options.insert(QStringLiteral("advanced"), advanced);
+                QJsonObject payload;
+                payload.insert(QStringLiteral("options"), options);
+                m_lastSeenRequested = true;
+                bridgeRequest(QStringLiteral("options"), payload,
+                              [this](CmdStatus status, const QJsonObject &, const QString &) {
+                    // Ask again the next time the bridge comes online.
+                    if (status != CmdStatus::Success)
+                        m_lastSeenRequested = false;
+                });
             }
-            const QJsonObject resp = doc.object();
-            const QString status = resp.value(QStringLiteral("status")).toString().trimmed().toLower();
-            const bool restartRequired = resp.value(QStringLiteral("restart_required")).toBool(false);
             return;
         }
-        if (suffix == QStringLiteral("bridge/response/device/get")) {
-            QJsonParseError err;
-            const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-            if (err.error != QJsonParseError::NoError || !doc.isObject()) {
-                return;
-            }
-            const QJsonObject resp = doc.object();
-            const QJsonObject data = resp.value(QStringLiteral("data")).toObject();
-            const QJsonObject deviceObj = data.isEmpty() ? resp : data;
-            const QString ieee = deviceObj.value(QStringLiteral("ieee_address")).toString().trimmed();
-            const QString friendly = deviceObj.value(QStringLiteral("friendly_name")).toString().trimmed();
-            if (!ieee.isEmpty() && m_pendingRename.contains(ieee)) {
-                const PendingRename pending = m_pendingRename.take(ieee);
-                CmdResponse response;
-                response.id = pending.cmdId;
-                response.tsMs = QDateTime::currentMSecsSinceEpoch();
-                if (!friendly.isEmpty() && friendly == pending.targetName) {
-                    response.status = CmdStatus::Success;
-                } else {
-                    response.status = CmdStatus::Failure;
-                    response.error = QStringLiteral("Rename not applied");
-                }
-                emit cmdResult(response);
-            }
+        return;
+    }
+    case Z2mTopicClass::BridgeHealth: {
+        if (!doc.isObject()) {
             return;
         }
-        if (suffix == QStringLiteral("bridge/info")) {
-            QJsonParseError err;
-            const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-            if (err.error != QJsonParseError::NoError || !doc.isObject()) {
-                return;
-            }
-            handleBridgeInfoPayload(doc.object(), QDateTime::currentMSecsSinceEpoch());
+        QJsonObject metaPatch;
+        metaPatch.insert(QStringLiteral("health"), doc.object());
+        emit adapterMetaUpdated(metaPatch);
+        return;
+    }
+    case Z2mTopicClass::BridgeResponse:
+        if (doc.isObject())
+            handleBridgeResponse(doc.object());
+        return;
+    case Z2mTopicClass::BridgeInfo: {
+        if (!doc.isObject()) {
             return;
         }
-        if (suffix == QStringLiteral("bridge/devices")
-            || suffix == QStringLiteral("bridge/response/devices")) {
-            QJsonParseError err;
-            const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-            if (err.error != QJsonParseError::NoError) {
-                return;
-            }
-            QJsonArray devices;
-            if (doc.isArray()) {
-                devices = doc.array();
-            } else if (doc.isObject()) {
-                const QJsonObject obj = doc.object();
-                const QJsonValue data = obj.value(QStringLiteral("data"));
-                if (data.isArray())
-                    devices = data.toArray();
-                else if (obj.value(QStringLiteral("status")).toString().trimmed().toLower() == QStringLiteral("ok")
-                         && obj.contains(QStringLiteral("result"))
-                         && obj.value(QStringLiteral("result")).isArray()) {
-                    devices = obj.value(QStringLiteral("result")).toArray();
-                }
-            }
-            if (devices.isEmpty()) {
-                return;
-            }
-            const bool fullSnapshot = (suffix == QStringLiteral("bridge/devices"));
-            handleBridgeDevicesPayload(devices, fullSnapshot);
-        }
+        handleBridgeInfoPayload(doc.object(), QDateTime::currentMSecsSinceEpoch());
         return;
     }
-
-    if (suffix.endsWith(QStringLiteral("/availability"))) {
-        const int slashIndex = suffix.indexOf(QLatin1Char('/'));
-        if (slashIndex <= 0)
+    case Z2mTopicClass::BridgeDevices:
+    case Z2mTopicClass::BridgeDevicesResponse: {
+        // Not pre-parsed by the decode stage; see handleBridgeDevicesPayload().
+        const QByteArrayView devices = bridgeDevicesArray(mqttMessage.payload());
+        if (devices.isEmpty()) {
             return;
-        const QString deviceId = suffix.left(slashIndex);
-        QString payloadText = QString::fromUtf8(message).trimmed();
-        if (payloadText.startsWith(QLatin1Char('{'))) {
-            QJsonParseError err;
-            const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-            if (err.error == QJsonParseError::NoError && doc.isObject()) {
-                payloadText = doc.object().value(QStringLiteral("state")).toString(payloadText);
-            }
         }
-        handleAvailabilityPayload(deviceId, payloadText, QDateTime::currentMSecsSinceEpoch());
+        const bool fullSnapshot = (topicClass == Z2mTopicClass::BridgeDevices);
+        handleBridgeDevicesPayload(devices, fullSnapshot);
         return;
     }
-
-    if (suffix.endsWith(QStringLiteral("/get")) || suffix.endsWith(QStringLiteral("/set"))) {
+    case Z2mTopicClass::BridgeNetworkMap:
+        if (doc.isObject()) {
+            handleBridgeResponse(doc.object());
+            handleNetworkMapPayload(doc.object());
+        }
+        return;
+    case Z2mTopicClass::BridgeGroups:
+        if (doc.isArray())
+            handleBridgeGroupsPayload(doc.array());
+        return;
+    case Z2mTopicClass::Availability: {
+        const QJsonValue state = doc.object().value(QStringLiteral("state"));
+        const ConnectivityStatus status = state.isString()
+            ? connectivityFromAvailability(state.toString())
+            : connectivityFromAvailability(trimmedView(mqttMessage.payload()));
+        handleAvailabilityPayload(route.deviceId, status, QDateTime::currentMSecsSinceEpoch(), route.device);
         return;
     }
-    if (suffix.endsWith(QStringLiteral("/action"))) {
-        const int slashIndex = suffix.indexOf(QLatin1Char('/'));
-        if (slashIndex <= 0)
-            return;
-        const QString deviceId = suffix.left(slashIndex);
+    case Z2mTopicClass::Action: {
         QJsonObject payloadObj;
-        const QString payloadText = QString::fromUtf8(message).trimmed();
-        if (payloadText.startsWith(QLatin1Char('{'))) {
-            QJsonParseError err;
-            const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-            if (err.error == QJsonParseError::NoError && doc.isObject()) {
-                payloadObj = doc.object();
-            } else if (!payloadText.isEmpty()) {
-                payloadObj.insert(QStringLiteral("action"), payloadText);
-            }
+        const QByteArrayView payloadText = trimmedView(mqttMessage.payload());
+        if (doc.isObject()) {
+            payloadObj = doc.object();
         } else if (!payloadText.isEmpty()) {
-            payloadObj.insert(QStringLiteral("action"), payloadText);
+            payloadObj.insert(QStringLiteral("action"), QString::fromUtf8(payloadText));
         }
         if (!payloadObj.isEmpty()) {
             payloadObj.insert(QStringLiteral("_phi_action_topic"), true);
-            handleDeviceStatePayload(deviceId, payloadObj, QDateTime::currentMSecsSinceEpoch());
+            handleDeviceStatePayload(route.deviceId, payloadObj, QDateTime::currentMSecsSinceEpoch(),
+                                     route.device);
         }
         return;
     }
-    if (suffix.contains(QLatin1Char('/'))) {
+    case Z2mTopicClass::DeviceState:
+        if (!doc.isObject()) {
+            return;
+        }
+        handleDeviceStatePayload(route.deviceId, doc.object(), QDateTime::currentMSecsSinceEpoch(),
+                                 route.device);
         return;
     }
+}
 
-    QJsonParseError err;
-    const QJsonDocument doc = QJsonDocument::fromJson(message, &err);
-    if (err.error != QJsonParseError::NoError || !doc.isObject()) {
+void Z2mAdapter::handleBridgeDevicesPayload(QByteArrayView devicesJson, bool fullSnapshot)
+{
+    // Parse one device at a time so peak memory stays at roughly a single
+    // device's DOM instead of the whole (multi-megabyte) snapshot.
+    QSet<DeviceHandle> seen;
+    bool routesChanged = false;
+    bool anyDevice = false;
+    bool malformed = false;
+    Z2mJsonArrayReader reader(devicesJson);
+    QByteArrayView element;
+    while (reader.next(element)) {
+        anyDevice = true;
+        QJsonParseError err;
+        const QJsonDocument doc = QJsonDocument::fromJson(
+            QByteArray::fromRawData(element.data(), element.size()), &err);
+        if (err.error != QJsonParseError::NoError) {
+            malformed = true;
+            continue;
+        }
+        if (doc.isObject())
+            handleBridgeDeviceObject(doc.object(), seen, routesChanged);
+    }
+    if (!anyDevice)
         return;
+
+    // A truncated or corrupt snapshot must not be mistaken for removed devices.
+    if (fullSnapshot && !reader.hasError() && !malformed) {
+        m_devices.forEach([&](DeviceHandle handle, const Z2mDeviceEntry &entry) {
+            if (seen.contains(handle))
+                return;
+            emit deviceRemoved(entry.device.id);
+            removeDevice(handle);
+            routesChanged = true;
+        });
     }
-    handleDeviceStatePayload(suffix, doc.object(), QDateTime::currentMSecsSinceEpoch());
+
+    if (routesChanged)
+        rebuildTopicRouter();
+    pruneDeviceTemplates();
 }
 
-void Z2mAdapter::handleBridgeDevicesPayload(const QJsonArray &devices, bool fullSnapshot)
+void Z2mAdapter::handleBridgeDeviceObject(const QJsonObject &obj, QSet<DeviceHandle> &seen, bool &routesChanged)
 {
-    QSet<QString> seen;
-    for (const QJsonValue &value : devices) {
-        if (!value.isObject())
-            continue;
-        const QJsonObject obj = value.toObject();
-        const QString deviceId = obj.value(QStringLiteral("friendly_name")).toString().trimmed();
-        if (deviceId.isEmpty())
-            continue;
-        const QString ieeeAddress = obj.value(QStringLiteral("ieee_address")).toString().trimmed();
-        const bool interviewCompleted = obj.value(QStringLiteral("interview_completed")).toBool(true);
-        const bool supported = obj.value(QStringLiteral("supported")).toBool(true);
-        if (!interviewCompleted || !supported) {
-            const QString existingMqttId = ieeeAddress.isEmpty()
-                ? deviceId
-                : m_mqttByExternal.value(ieeeAddress, deviceId);
-            if (m_devices.contains(existingMqttId)) {
-                emit deviceRemoved(m_devices.value(existingMqttId).device.id);
-                if (!m_devices.value(existingMqttId).device.id.isEmpty())
-                    m_mqttByExternal.remove(m_devices.value(existingMqttId).device.id);
-                m_devices.remove(existingMqttId);
-            }
-            m_pendingStatePayloads.remove(existingMqttId);
-            continue;
-        }
-        const QJsonObject def = obj.value(QStringLiteral("definition")).toObject();
-        const QJsonArray exposes = def.value(QStringLiteral("exposes")).toArray();
-        seen.insert(deviceId);
-        auto availabilityFromValue = [](const QJsonValue &val) -> QString {
-            if (val.isString())
-                return val.toString().trimmed();
-            if (val.isObject())
-                return val.toObject().value(QStringLiteral("state")).toString().trimmed();
-            return QString();
-        };
-        auto lastSeenMsFromValue = [](const QJsonValue &val) -> qint64 {
-            if (val.isDouble()) {
-                const double raw = val.toDouble();
-                if (raw > 1000000000000.0)
-                    return static_cast<qint64>(raw);
-                if (raw > 0.0)
-                    return static_cast<qint64>(raw * 1000.0);
-                return 0;
-            }
-            if (val.isString()) {
-                const QDateTime parsed = QDateTime::fromString(val.toString(), Qt::ISODate);
-                if (parsed.isValid())
-                    return parsed.toMSecsSinceEpoch();
-            }
+    const QString deviceId = obj.value(QStringLiteral("friendly_name")).toString().trimmed();
+    if (deviceId.isEmpty())
+        return;
+    const QString ieeeAddress = obj.value(QStringLiteral("ieee_address")).toString().trimmed();
+    const bool interviewCompleted = obj.value(QStringLiteral("interview_completed")).toBool(true);
+    const bool supported = obj.value(QStringLiteral("supported")).toBool(true);
+    const quint64 ieee = parseIeeeAddress(ieeeAddress);
+    DeviceHandle handle = ieee ? m_deviceByIeee.value(ieee) : m_deviceByName.value(deviceId);
+    Z2mDeviceEntry *existing = m_devices.get(handle);
+    if (!interviewCompleted || !supported) {
+        const QString existingMqttId = existing ? existing->mqttId : deviceId;
+        if (existing) {
+            emit deviceRemoved(existing->device.id);
+            removeDevice(handle);
+            routesChanged = true;
+        }
+        m_pendingStatePayloads.remove(existingMqttId);
+        return;
+    }
+    auto availabilityFromValue = [](const QJsonValue &val) -> QString {
+        if (val.isString())
+            return val.toString().trimmed();
+        if (val.isObject())
+            return val.toObject().value(QStringLiteral("state")).toString().trimmed();
+        return QString();
+    };
+    auto lastSeenMsFromValue = [](const QJsonValue &val) -> qint64 {
+        if (val.isDouble()) {
+            const double raw = val.toDouble();
+            if (raw > 1000000000000.0)
+                return static_cast<qint64>(raw);
+            if (raw > 0.0)
+                return static_cast<qint64>(raw * 1000.0);
             return 0;
-        };
-
-        bool renameDetected = false;
-        const QString previousMqttId = ieeeAddress.isEmpty()
-            ? QString()
-            : m_mqttByExternal.value(ieeeAddress);
-        if (!previousMqttId.isEmpty() && previousMqttId != deviceId) {
-            renameDetected = true;
-        }
-
-        Z2mDeviceEntry entry;
-        if (!previousMqttId.isEmpty() && m_devices.contains(previousMqttId)) {
-            entry = m_devices.value(previousMqttId);
-            entry.mqttId = deviceId;
-            entry.device.name = deviceId;
-            entry.device.meta.insert(QStringLiteral("friendly_name"), deviceId);
-            if (renameDetected) {
-                m_devices.remove(previousMqttId);
-            }
-        } else {
-            entry = buildDeviceEntry(obj);
         }
-        if (renameDetected) {
-            auto pendingIt = m_pendingStatePayloads.find(previousMqttId);
-            if (pendingIt != m_pendingStatePayloads.end()) {
-                m_pendingStatePayloads.insert(deviceId, pendingIt.value());
-                m_pendingStatePayloads.erase(pendingIt);
-            }
+        if (val.isString()) {
+            const QDateTime parsed = QDateTime::fromString(val.toString(), Qt::ISODate);
+            if (parsed.isValid())
+                return parsed.toMSecsSinceEpoch();
         }
+        return 0;
+    };
 
-        if (!ieeeAddress.isEmpty()) {
-            const auto pendingIt = m_pendingRename.constFind(ieeeAddress);
-            if (pendingIt != m_pendingRename.constEnd() && pendingIt.value().targetName == entry.mqttId) {
-                CmdResponse response;
-                response.id = pendingIt.value().cmdId;
-                response.tsMs = QDateTime::currentMSecsSinceEpoch();
-                response.status = CmdStatus::Success;
-                emit cmdResult(response);
-                m_pendingRename.remove(ieeeAddress);
-            }
-        }
-        m_devices.insert(entry.mqttId, entry);
-        if (!entry.device.id.isEmpty())
-            m_mqttByExternal.insert(entry.device.id, entry.mqttId);
-        emit deviceUpdated(entry.device, entry.channels);
-        auto pendingPayloadIt = m_pendingStatePayloads.find(entry.mqttId);
-        if (pendingPayloadIt != m_pendingStatePayloads.end()) {
-            const QJsonObject pendingPayload = pendingPayloadIt.value();
-            m_pendingStatePayloads.erase(pendingPayloadIt);
-            handleDeviceStatePayload(entry.mqttId, pendingPayload, QDateTime::currentMSecsSinceEpoch());
-        }
-        if (renameDetected) {
-            // Rename does not imply connectivity; avoid forcing Connected here.
-        }
-        QString availability = availabilityFromValue(obj.value(QStringLiteral("availability")));
-        if (availability.isEmpty())
-            availability = obj.value(QStringLiteral("availability_state")).toString().trimmed();
-        const qint64 lastSeenMs = lastSeenMsFromValue(obj.value(QStringLiteral("last_seen")));
-        for (const Z2mChannelBinding &binding : entry.bindingsByChannel) {
-            if (!binding.isAvailability)
-                continue;
-            const QString externalId = entry.device.id;
-            QTimer::singleShot(0, this, [this, availability, lastSeenMs, externalId, channelId = binding.channelId]() {
-                ConnectivityStatus status = ConnectivityStatus::Unknown;
-                QString state = availability.toLower();
-                if (state.isEmpty()) {
-                    constexpr qint64 kStaleThresholdMs = 5 * 60 * 1000;
-                    if (lastSeenMs > 0) {
-                        const qint64 ageMs = QDateTime::currentMSecsSinceEpoch() - lastSeenMs;
-                        status = ageMs > kStaleThresholdMs
-                            ? ConnectivityStatus::Disconnected
-                            : ConnectivityStatus::Connected;
-                    } else {
-                        return;
-                    }
-                } else if (state == QStringLiteral("online")) {
-                    status = ConnectivityStatus::Connected;
-                } else if (state == QStringLiteral("offline")) {
-                    status = ConnectivityStatus::Disconnected;
-                }
-                emit channelStateUpdated(externalId, channelId,
-                                         static_cast<int>(status),
-                                         QDateTime::currentMSecsSinceEpoch());
-            });
-            break;
-        }
+    // Endpoints are not part of the digest; scenes stored on them are
+    // synced on every snapshot.
+    QList<Z2mSceneEntry> scenes;
+    const QString externalId = !ieeeAddress.isEmpty() ? ieeeAddress : deviceId;
+    const QJsonObject endpoints = obj.value(QStringLiteral("endpoints")).toObject();
+    for (auto it = endpoints.begin(); it != endpoints.end(); ++it) {
+        collectScenes(it.value().toObject().value(QStringLiteral("scenes")).toArray(), externalId,
+                      QStringLiteral("device"), it.key(), scenes);
+    }
+    replaceTargetScenes(externalId, std::move(scenes));
+
+    // A rename changes the digest (friendly_name is part of it), so an
+    // unchanged digest means there is nothing to rebuild or re-send.
+    const size_t digest = deviceDefinitionDigest(obj);
+    if (existing && existing->definitionDigest == digest) {
+        seen.insert(handle);
+        return;
+    }
 
-        const QString deviceType = obj.value(QStringLiteral("type")).toString();
-        if (deviceType.compare(QStringLiteral("Coordinator"), Qt::CaseInsensitive) == 0) {
-            m_coordinatorId = entry.device.id;
-            if (!m_pendingBridgeInfo.isEmpty()) {
-                handleBridgeInfoPayload(m_pendingBridgeInfo, QDateTime::currentMSecsSinceEpoch());
-                m_pendingBridgeInfo = QJsonObject();
+    const QString previousMqttId = existing ? existing->mqttId : QString();
+    const bool renameDetected = existing && previousMqttId != deviceId;
+    Z2mDeviceEntry built = buildDeviceEntry(obj);
+    built.definitionDigest = digest;
+    if (existing) {
+        // Keep meta that only arrives through device state payloads.
+        const QJsonObject &previousMeta = existing->device.meta;
+        for (const QString &key : {QStringLiteral("update"),
+                                   QStringLiteral("last_seen"),
+                                   QStringLiteral("commandLatencyMs")}) {
+            if (previousMeta.contains(key) && !built.device.meta.contains(key))
+                built.device.meta.insert(key, previousMeta.value(key));
+        }
+        // Same shared template (e.g. a rename): indexes are unchanged, so
+        // in-flight button/dial state and cached values stay valid.
+        if (existing->deviceTemplate == built.deviceTemplate)
+            built.channelRuntime = std::move(existing->channelRuntime);
+        built.commandLatency = existing->commandLatency;
+        // Rebuilt in place: the handle, and with it the IEEE index and any
+        // deferred callbacks holding it, stay valid across renames.
+        *existing = std::move(built);
+    } else {
+        handle = m_devices.insert(std::move(built));
+        routesChanged = true;
+    }
+    indexDevice(handle, previousMqttId);
+    seen.insert(handle);
+    Z2mDeviceEntry &entry = *m_devices.get(handle);
+    if (renameDetected) {
+        routesChanged = true;
+        auto pendingIt = m_pendingStatePayloads.find(previousMqttId);
+        if (pendingIt != m_pendingStatePayloads.end()) {
+            m_pendingStatePayloads.insert(deviceId, pendingIt.value());
+            m_pendingStatePayloads.erase(pendingIt);
+        }
+    }
+
+    if (!ieeeAddress.isEmpty()) {
+        // Bridges that do not echo transactions still publish the renamed
+        // device; complete the request from the snapshot then.
+        const auto pendingIt = m_pendingRename.constFind(ieeeAddress);
+        if (pendingIt != m_pendingRename.constEnd() && pendingIt.value().targetName == entry.mqttId)
+            resolveBridgeRequest(pendingIt.value().transaction, CmdStatus::Success);
+    }
+    emit deviceUpdated(entry.device, entry.deviceTemplate->channels);
+    auto pendingPayloadIt = m_pendingStatePayloads.find(entry.mqttId);
+    if (pendingPayloadIt != m_pendingStatePayloads.end()) {
+        const QJsonObject pendingPayload = pendingPayloadIt.value();
+        m_pendingStatePayloads.erase(pendingPayloadIt);
+        handleDeviceStatePayload(entry.mqttId, pendingPayload, QDateTime::currentMSecsSinceEpoch(), handle);
+    }
+    if (renameDetected) {
+        // Rename does not imply connectivity; avoid forcing Connected here.
+    }
+    QString availability = availabilityFromValue(obj.value(QStringLiteral("availability")));
+    if (availability.isEmpty())
+        availability = obj.value(QStringLiteral("availability_state")).toString().trimmed();
+    const qint64 lastSeenMs = lastSeenMsFromValue(obj.value(QStringLiteral("last_seen")));
+    for (const Z2mChannelBinding &binding : entry.deviceTemplate->bindingsByChannel) {
+        if (!binding.isAvailability)
+            continue;
+        m_timers.schedule(0, [this, availability, lastSeenMs, handle, channelId = binding.channelId]() {
+            ConnectivityStatus status = ConnectivityStatus::Unknown;
+            QString state = availability.toLower();
+            if (state.isEmpty()) {
+                constexpr qint64 kStaleThresholdMs = 5 * 60 * 1000;
+                if (lastSeenMs > 0) {
+                    const qint64 ageMs = QDateTime::currentMSecsSinceEpoch() - lastSeenMs;
+                    status = ageMs > kStaleThresholdMs
+                        ? ConnectivityStatus::Disconnected
+                        : ConnectivityStatus::Connected;
+                } else {
+                    return;
+                }
+            } else if (state == QStringLiteral("online")) {
+                status = ConnectivityStatus::Connected;
+            } else if (state == QStringLiteral("offline")) {
+                status = ConnectivityStatus::Disconnected;
             }
-        }
+            Z2mDeviceEntry *found = m_devices.get(handle);
+            if (!found)
+                return;
+            Z2mDeviceEntry &current = *found;
+            const auto bindingIt = current.deviceTemplate->bindingsByChannel.constFind(channelId);
+            if (bindingIt == current.deviceTemplate->bindingsByChannel.cend())
+                return;
+            emitChannelState(current, bindingIt.value(), static_cast<int>(status),
+                             QDateTime::currentMSecsSinceEpoch());
+        });
+        break;
     }
 
-    if (fullSnapshot) {
-        auto it = m_devices.begin();
-        while (it != m_devices.end()) {
-            if (!seen.contains(it.key())) {
-                emit deviceRemoved(it.value().device.id);
-                if (!it.value().device.id.isEmpty())
-                    m_mqttByExternal.remove(it.value().device.id);
-                it = m_devices.erase(it);
-                continue;
-            }
-            ++it;
+    const QString deviceType = obj.value(QStringLiteral("type")).toString();
+    if (deviceType.compare(QStringLiteral("Coordinator"), Qt::CaseInsensitive) == 0) {
+        m_coordinatorId = entry.device.id;
+        if (!m_pendingBridgeInfo.isEmpty()) {
+            handleBridgeInfoPayload(m_pendingBridgeInfo, QDateTime::currentMSecsSinceEpoch());
+            m_pendingBridgeInfo = QJsonObject();
         }
     }
-
 }
 
 void Z2mAdapter::handleDeviceStatePayload(const QString &deviceId,
                                           const QJsonObject &payload,
-                                          qint64 tsMs)
+                                          qint64 tsMs,
+                                          DeviceHandle handle)
 {
-    const auto deviceIt = m_devices.find(deviceId);
-    if (deviceIt == m_devices.end()) {
+    Z2mDeviceEntry *device = m_devices.get(handle);
+    if (!device)
+        device = findDeviceByName(deviceId);
+    if (!device) {
         m_pendingStatePayloads.insert(deviceId, payload);
         return;
     }
-    Z2mDeviceEntry &entry = deviceIt.value();
+    Z2mDeviceEntry &entry = *device;
     const QString externalId = entry.device.id;
-    bool metaChanged = false;
+    QJsonObject metaPatch;
     bool connectivityUpdated = false;
     ConnectivityStatus connectivityStatus = ConnectivityStatus::Unknown;
     if (payload.contains(QStringLiteral("update")) && payload.value(QStringLiteral("update")).isObject()) {
-        entry.device.meta.insert(QStringLiteral("update"), payload.value(QStringLiteral("update")).toObject());
-        metaChanged = true;
+        const QJsonValue updateValue = payload.value(QStringLiteral("update"));
+        if (entry.device.meta.value(QStringLiteral("update")) != updateValue) {
+            entry.device.meta.insert(QStringLiteral("update"), updateValue);
+            metaPatch.insert(QStringLiteral("update"), updateValue);
+        }
     }
     if (payload.contains(QStringLiteral("last_seen"))) {
         const QJsonValue lastSeenValue = payload.value(QStringLiteral("last_seen"));
+        // Always kept current for full syncs, but only reported at a bounded
+        // rate: with last_seen enabled it changes on every state message.
         entry.device.meta.insert(QStringLiteral("last_seen"), lastSeenValue);
-        metaChanged = true;
+        if (entry.lastSeenReportedMs == 0 || tsMs - entry.lastSeenReportedMs >= kLastSeenReportIntervalMs) {
+            metaPatch.insert(QStringLiteral("last_seen"), lastSeenValue);
+            entry.lastSeenReportedMs = tsMs;
+        }
         qint64 lastSeenMs = 0;
         if (lastSeenValue.isDouble()) {
             const double raw = lastSeenValue.toDouble();
@@ -1345,453 +1726,787 @@ void Z2mAdapter::handleDeviceStatePayload(const QString &deviceId,
         connectivityStatus = ConnectivityStatus::Connected;
         connectivityUpdated = true;
     }
-    if (metaChanged) {
-        emit deviceUpdated(entry.device, entry.channels);
-    }
+    if (!metaPatch.isEmpty())
+        emit deviceMetaUpdated(externalId, metaPatch);
 
-    for (auto it = entry.bindingsByChannel.begin(); it != entry.bindingsByChannel.end(); ++it) {
+    for (auto it = entry.deviceTemplate->bindingsByChannel.cbegin();
+         it != entry.deviceTemplate->bindingsByChannel.cend();
+         ++it) {
         const Z2mChannelBinding &binding = it.value();
         if (!binding.isAvailability)
             continue;
-        if (connectivityUpdated) {
-            emit channelStateUpdated(externalId, binding.channelId,
-                                     static_cast<int>(connectivityStatus), tsMs);
-        }
+        if (connectivityUpdated)
+            emitChannelState(entry, binding, static_cast<int>(connectivityStatus), tsMs);
         break;
     }
 
-    for (auto it = entry.bindingsByChannel.begin(); it != entry.bindingsByChannel.end(); ++it) {
-        const Z2mChannelBinding &binding = it.value();
-        if (binding.isAvailability)
-            continue;
-        if (binding.channelId == QStringLiteral("device_software_update")) {
-            const QJsonValue updateValue = payload.value(QStringLiteral("update"));
-            if (updateValue.isObject()) {
-                const QJsonObject updateObj = updateValue.toObject();
-                const QString status = updateObj.value(QStringLiteral("state")).toString();
-                const QString currentVersion = updateObj.contains(QStringLiteral("installed_version"))
-                    ? QString::number(updateObj.value(QStringLiteral("installed_version")).toDouble(), 'f', 0)
-                    : QString();
-                const QString targetVersion = updateObj.contains(QStringLiteral("latest_version"))
-                    ? QString::number(updateObj.value(QStringLiteral("latest_version")).toDouble(), 'f', 0)
-                    : QString();
-                QJsonObject updatePayload;
-                if (!status.isEmpty())
-                    updatePayload.insert(QStringLiteral("status"), status);
-                if (!currentVersion.isEmpty())
-                    updatePayload.insert(QStringLiteral("currentVersion"), currentVersion);
-                if (!targetVersion.isEmpty())
-                    updatePayload.insert(QStringLiteral("targetVersion"), targetVersion);
-                emit channelStateUpdated(externalId, binding.channelId, updatePayload, tsMs);
-            }
-            continue;
+    // Walk the payload's own keys: a one-field report costs one index lookup
+    // regardless of how many channels the device has.
+    const Z2mDeviceTemplate &compiled = *entry.deviceTemplate;
+    for (auto keyIt = payload.constBegin(); keyIt != payload.constEnd(); ++keyIt) {
+        const auto range = compiled.channelByProperty.equal_range(keyIt.key());
+        for (auto channelIt = range.first; channelIt != range.second; ++channelIt) {
+            const auto bindingIt = compiled.bindingsByChannel.constFind(channelIt.value());
+            if (bindingIt == compiled.bindingsByChannel.constEnd() || bindingIt.value().isAvailability)
+                continue;
+            decodeBindingState(entry, bindingIt.value(), keyIt.value(), payload, tsMs);
         }
-        const QJsonValue value = payload.value(binding.property);
-        if (value.isUndefined())
-            continue;
-
-        QVariant outValue;
-        if (binding.property == QStringLiteral("action") && value.isString()) {
-            const QString actionRaw = value.toString();
-            const QString actionNorm = actionRaw.trimmed().toLower();
-            if (binding.actionIsDial) {
-                const QString timerKey = externalId + QStringLiteral(":") + binding.channelId;
-                if (payload.value(QStringLiteral("_phi_action_topic")).toBool(false)) {
-                    const int directionHint = parseDialDirectionHint(actionRaw, payload);
-                    if (directionHint != 0) {
-                        m_pendingDialDirectionByChannel.insert(timerKey, directionHint);
-                        m_pendingDialDirectionTsByChannel.insert(timerKey, tsMs);
-                    }
-                    continue;
-                }
-                if (!isDialAction(actionRaw))
-                    continue;
-                const int magnitude = parseDialMagnitude(actionRaw, payload);
-                if (magnitude <= 0)
-                    continue;
-                int sign = parseDialDirectionHint(actionRaw, payload);
-
-                const int cachedDir = m_pendingDialDirectionByChannel.value(timerKey, 0);
-                const qint64 cachedTs = m_pendingDialDirectionTsByChannel.value(timerKey, 0);
-                if (sign == 0 && cachedDir != 0 && cachedTs > 0 && (tsMs - cachedTs) <= kDialDirectionCacheMs) {
-                    sign = cachedDir;
-                    m_pendingDialDirectionByChannel.remove(timerKey);
-                    m_pendingDialDirectionTsByChannel.remove(timerKey);
-                }
-                if (sign == 0)
-                    sign = 1;
+    }
+}
 
-                outValue = sign * magnitude;
-            } else {
-                if (!actionNorm.isEmpty()) {
-                    const QString actionKey = externalId
-                        + QStringLiteral(":")
-                        + binding.channelId
-                        + QStringLiteral(":")
-                        + actionNorm;
-                    const qint64 lastActionTs = m_recentActionTs.value(actionKey, 0);
-                    if (lastActionTs > 0 && (tsMs - lastActionTs) <= kActionDuplicateWindowMs)
-                        continue;
-                    m_recentActionTs.insert(actionKey, tsMs);
-                    if (m_recentActionTs.size() > 512) {
-                        const qint64 minTs = tsMs - 10000;
-                        for (auto rit = m_recentActionTs.begin(); rit != m_recentActionTs.end();) {
-                            if (rit.value() < minTs)
-                                rit = m_recentActionTs.erase(rit);
-                            else
-                                ++rit;
-                        }
-                    }
-                }
-                const int actionButtonId = extractActionButtonId(actionRaw);
-                if (binding.actionButtonId > 0 && actionButtonId > 0
-                    && actionButtonId != binding.actionButtonId) {
-                    continue;
-                }
-                if (binding.actionButtonId > 0 && actionButtonId == 0)
-                    continue;
-                if (actionNorm.startsWith(QStringLiteral("scene_"))) {
-                    const QString pressKey = externalId + QStringLiteral(":") + binding.channelId;
-                    const qint64 lastTs = m_buttonMultiPressLastTs.value(pressKey, 0);
-                    const int count = m_buttonMultiPressCounts.value(pressKey, 0);
-                    if (count > 0 && lastTs > 0 && (tsMs - lastTs) >= kButtonMultiPressResetGapMs)
-                        finalizePendingButtonShortPress(pressKey, externalId, binding.channelId, lastTs);
-                    emit channelStateUpdated(externalId,
-                                             binding.channelId,
-                                             static_cast<int>(ButtonEventCode::InitialPress),
-                                             tsMs);
-                    handleButtonShortPressRelease(pressKey, externalId, binding.channelId, tsMs);
-                    m_buttonLastEventCode.remove(pressKey);
-                    m_buttonLastEventTs.remove(pressKey);
-                    continue;
-                }
-                ButtonEventCode code = actionToButtonEvent(actionRaw);
-                if (code == ButtonEventCode::None) {
-                    const QJsonValue actionTypeVal = payload.value(QStringLiteral("action_type"));
-                    if (actionTypeVal.isString())
-                        code = mapActionTypeToButtonEvent(actionTypeVal.toString());
+void Z2mAdapter::decodeBindingState(Z2mDeviceEntry &entry,
+                                    const Z2mChannelBinding &binding,
+                                    const QJsonValue &value,
+                                    const QJsonObject &payload,
+                                    qint64 tsMs)
+{
+    const QString externalId = entry.device.id;
+    if (binding.channelId == QStringLiteral("device_software_update")) {
+        if (value.isObject()) {
+            const QJsonObject updateObj = value.toObject();
+            const QString status = updateObj.value(QStringLiteral("state")).toString();
+            const QString currentVersion = updateObj.contains(QStringLiteral("installed_version"))
+                ? QString::number(updateObj.value(QStringLiteral("installed_version")).toDouble(), 'f', 0)
+                : QString();
+            const QString targetVersion = updateObj.contains(QStringLiteral("latest_version"))
+                ? QString::number(updateObj.value(QStringLiteral("latest_version")).toDouble(), 'f', 0)
+                : QString();
+            QJsonObject updatePayload;
+            if (!status.isEmpty())
+                updatePayload.insert(QStringLiteral("status"), status);
+            if (!currentVersion.isEmpty())
+                updatePayload.insert(QStringLiteral("currentVersion"), currentVersion);
+            if (!targetVersion.isEmpty())
+                updatePayload.insert(QStringLiteral("targetVersion"), targetVersion);
+            emitChannelState(entry, binding, updatePayload, tsMs);
+        }
+        return;
+    }
+    Z2mChannelRuntime &runtime = entry.channelRuntime[binding.index];
+    QVariant outValue;
+    if (binding.property == QStringLiteral("action") && value.isString()) {
+        const QString actionRaw = value.toString();
+        // Actions listed in the expose were compiled with the template; only
+        // values the definition did not announce are parsed here.
+        const auto vocabularyIt = entry.deviceTemplate->actionVocabulary.constFind(actionRaw);
+        const Z2mActionInfo action = vocabularyIt != entry.deviceTemplate->actionVocabulary.cend()
+            ? vocabularyIt.value()
+            : compileAction(actionRaw);
+        const QString &actionNorm = action.normalized;
+        if (binding.actionIsDial) {
+            const int directionHint = action.dialDirection != 0
+                ? action.dialDirection
+                : dialDirectionFromPayload(payload);
+            if (payload.value(QStringLiteral("_phi_action_topic")).toBool(false)) {
+                if (directionHint != 0) {
+                    runtime.pendingDialDirection = directionHint;
+                    runtime.pendingDialDirectionTs = tsMs;
                 }
-                if (code == ButtonEventCode::None)
-                    continue;
-                outValue = static_cast<int>(code);
+                return;
             }
-        }
+            if (!action.isDial)
+                return;
+            // A zero step in the payload means no movement; otherwise a step
+            // encoded in the action name wins over the payload's.
+            int magnitude = dialMagnitudeFromPayload(payload, 1);
+            if (magnitude <= 0)
+                return;
+            if (action.dialMagnitude > 0)
+                magnitude = action.dialMagnitude;
+            int sign = directionHint;
+
+            const int cachedDir = runtime.pendingDialDirection;
+            const qint64 cachedTs = runtime.pendingDialDirectionTs;
+            if (sign == 0 && cachedDir != 0 && cachedTs > 0 && (tsMs - cachedTs) <= kDialDirectionCacheMs) {
+                sign = cachedDir;
+                runtime.pendingDialDirection = 0;
+                runtime.pendingDialDirectionTs = 0;
+            }
+            if (sign == 0)
+                sign = 1;
 
-        if (outValue.isValid()) {
-            if (binding.kind == ChannelKind::ButtonEvent && !binding.actionIsDial) {
-                int code = outValue.toInt();
-                const QString pressKey = externalId + QStringLiteral(":") + binding.channelId;
-                if (code == static_cast<int>(ButtonEventCode::InitialPress)) {
-                    const qint64 lastTs = m_buttonMultiPressLastTs.value(pressKey, 0);
-                    const int count = m_buttonMultiPressCounts.value(pressKey, 0);
-                    if (count > 0 && lastTs > 0 && (tsMs - lastTs) >= kButtonMultiPressResetGapMs)
-                        finalizePendingButtonShortPress(pressKey, externalId, binding.channelId, lastTs);
-                }
-                if (code == static_cast<int>(ButtonEventCode::ShortPressRelease)) {
-                    handleButtonShortPressRelease(pressKey, externalId, binding.channelId, tsMs);
-                    m_buttonLastEventCode.remove(pressKey);
-                    m_buttonLastEventTs.remove(pressKey);
-                    continue;
-                }
-                if (code == static_cast<int>(ButtonEventCode::LongPress)) {
-                    const int prevCode = m_buttonLastEventCode.value(pressKey, 0);
-                    const qint64 prevTs = m_buttonLastEventTs.value(pressKey, 0);
-                    if ((prevCode == static_cast<int>(ButtonEventCode::LongPress)
-                         || prevCode == static_cast<int>(ButtonEventCode::Repeat))
-                        && prevTs > 0
-                        && (tsMs - prevTs) <= kLongPressRepeatWindowMs) {
-                        code = static_cast<int>(ButtonEventCode::Repeat);
-                        outValue = code;
-                    }
-                }
-                if (code == static_cast<int>(ButtonEventCode::LongPressRelease)) {
-                    m_buttonLastEventCode.remove(pressKey);
-                    m_buttonLastEventTs.remove(pressKey);
-                } else {
-                    m_buttonLastEventCode.insert(pressKey, code);
-                    m_buttonLastEventTs.insert(pressKey, tsMs);
+            outValue = sign * magnitude;
+        } else {
+            if (!actionNorm.isEmpty()) {
+                // The same action repeated by both the state and the /action
+                // topic arrives within a few ms; report it once.
+                if (runtime.lastActionTs > 0
+                    && (tsMs - runtime.lastActionTs) <= kActionDuplicateWindowMs
+                    && runtime.lastAction == actionNorm) {
+                    return;
                 }
+                runtime.lastAction = actionNorm;
+                runtime.lastActionTs = tsMs;
             }
-            emit channelStateUpdated(externalId, binding.channelId, outValue, tsMs);
-            if (binding.actionIsDial) {
-                const QString timerKey = externalId + QStringLiteral(":") + binding.channelId;
-                m_lastDialValueByChannel.insert(timerKey, outValue.toInt());
-                QTimer *timer = m_dialResetTimers.value(timerKey);
-                if (!timer) {
-                    timer = new QTimer(this);
-                    timer->setSingleShot(true);
-                    m_dialResetTimers.insert(timerKey, timer);
-                    connect(timer, &QTimer::timeout, this, [this, externalId, channelId = binding.channelId, timerKey]() {
-                        if (m_lastDialValueByChannel.value(timerKey, 0) == 0)
-                            return;
-                        emit channelStateUpdated(externalId, channelId, 0, QDateTime::currentMSecsSinceEpoch());
-                        m_lastDialValueByChannel.insert(timerKey, 0);
-                    });
-                }
-                timer->start(700);
-            } else if (binding.kind == ChannelKind::ButtonEvent) {
-                const int code = outValue.toInt();
-                const QString pressKey = externalId + QStringLiteral(":") + binding.channelId;
-                if (code != static_cast<int>(ButtonEventCode::InitialPress)) {
-                    m_buttonMultiPressCounts.remove(pressKey);
-                    m_buttonMultiPressLastTs.remove(pressKey);
-                    if (code == static_cast<int>(ButtonEventCode::LongPressRelease)) {
-                        m_buttonLastEventCode.remove(pressKey);
-                        m_buttonLastEventTs.remove(pressKey);
-                    }
-                    QTimer *timer = m_buttonMultiPressTimers.value(pressKey);
-                    if (timer)
-                        timer->stop();
-                }
+            const int actionButtonId = action.buttonId;
+            if (binding.actionButtonId > 0 && actionButtonId > 0
+                && actionButtonId != binding.actionButtonId) {
+                return;
             }
-            continue;
+            if (binding.actionButtonId > 0 && actionButtonId == 0)
+                return;
+            if (action.isScene) {
+                const qint64 lastTs = runtime.multiPressLastTs;
+                if (runtime.multiPressCount > 0 && lastTs > 0 && (tsMs - lastTs) >= kButtonMultiPressResetGapMs)
+                    finalizePendingButtonShortPress(entry, binding, lastTs);
+                emit channelStateUpdated(externalId,
+                                         binding.channelId,
+                                         static_cast<int>(ButtonEventCode::InitialPress),
+                                         tsMs);
+                handleButtonShortPressRelease(entry, binding, tsMs);
+                runtime.lastEventCode = 0;
+                runtime.lastEventTs = 0;
+                return;
+            }
+            ButtonEventCode code = action.code;
+            if (code == ButtonEventCode::None) {
+                const QJsonValue actionTypeVal = payload.value(QStringLiteral("action_type"));
+                if (actionTypeVal.isString())
+                    code = mapActionTypeToButtonEvent(actionTypeVal.toString());
+            }
+            if (code == ButtonEventCode::None)
+                return;
+            outValue = static_cast<int>(code);
         }
+    }
 
-        switch (binding.kind) {
-        case ChannelKind::PowerOnOff: {
-            if (value.isBool()) {
-                outValue = value.toBool();
-            } else if (value.isString()) {
-                const QString state = value.toString();
-                if (!binding.valueOn.isEmpty() || !binding.valueOff.isEmpty()) {
-                    outValue = state.compare(binding.valueOn, Qt::CaseInsensitive) == 0;
-                } else {
-                    outValue = state.compare(QStringLiteral("ON"), Qt::CaseInsensitive) == 0;
-                }
-            } else if (value.isDouble()) {
-                outValue = value.toDouble() != 0.0;
+    if (outValue.isValid()) {
+        if (binding.kind == ChannelKind::ButtonEvent && !binding.actionIsDial) {
+            int code = outValue.toInt();
+            if (code == static_cast<int>(ButtonEventCode::InitialPress)) {
+                const qint64 lastTs = runtime.multiPressLastTs;
+                if (runtime.multiPressCount > 0 && lastTs > 0 && (tsMs - lastTs) >= kButtonMultiPressResetGapMs)
+                    finalizePendingButtonShortPress(entry, binding, lastTs);
             }
-            break;
-        }
-        case ChannelKind::Brightness: {
-            const double raw = value.toDouble();
-            outValue = scaleToPercent(raw, binding.rawMin, binding.rawMax);
-            break;
-        }
-        case ChannelKind::ColorTemperature: {
-            outValue = value.toDouble();
-            break;
-        }
-        case ChannelKind::ColorRGB: {
-            if (!value.isObject())
-                break;
-            const QJsonObject colorObj = value.toObject();
-            if (binding.colorMode == QStringLiteral("xy")) {
-                const double x = colorObj.value(QStringLiteral("x")).toDouble();
-                const double y = colorObj.value(QStringLiteral("y")).toDouble();
-                phicore::adapter::Color c = phicore::adapter::colorFromXy(x, y, 1.0);
-                outValue = QVariant::fromValue(c);
-            } else if (binding.colorMode == QStringLiteral("hs")) {
-                const double h = colorObj.value(QStringLiteral("hue")).toDouble(colorObj.value(QStringLiteral("h")).toDouble());
-                const double s = colorObj.value(QStringLiteral("saturation")).toDouble(colorObj.value(QStringLiteral("s")).toDouble());
-                phicore::adapter::Color c = phicore::adapter::hsvToColor(h, s / 100.0, 1.0);
-                outValue = QVariant::fromValue(c);
+            if (code == static_cast<int>(ButtonEventCode::ShortPressRelease)) {
+                handleButtonShortPressRelease(entry, binding, tsMs);
+                runtime.lastEventCode = 0;
+                runtime.lastEventTs = 0;
+                return;
             }
-            break;
-        }
-        case ChannelKind::Temperature:
-        case ChannelKind::Humidity:
-        case ChannelKind::Illuminance:
-        case ChannelKind::CO2:
-        case ChannelKind::Power:
-        case ChannelKind::Voltage:
-        case ChannelKind::Current:
-        case ChannelKind::Energy: {
-            const double raw = value.toDouble();
-            outValue = raw * binding.valueScale;
-            break;
-        }
-        case ChannelKind::AmbientLightLevel: {
-            if (value.isString()) {
-                const QString raw = value.toString();
-                if (!binding.enumRawToValue.isEmpty()) {
-                    const auto it = binding.enumRawToValue.constFind(raw);
-                    if (it != binding.enumRawToValue.constEnd()) {
-                        outValue = it.value();
-                        break;
-                    }
+            if (code == static_cast<int>(ButtonEventCode::LongPress)) {
+                const int prevCode = runtime.lastEventCode;
+                const qint64 prevTs = runtime.lastEventTs;
+                if ((prevCode == static_cast<int>(ButtonEventCode::LongPress)
+                     || prevCode == static_cast<int>(ButtonEventCode::Repeat))
+                    && prevTs > 0
+                    && (tsMs - prevTs) <= kLongPressRepeatWindowMs) {
+                    code = static_cast<int>(ButtonEventCode::Repeat);
+                    outValue = code;
                 }
-                outValue = raw;
-            } else if (value.isDouble()) {
-                outValue = value.toInt();
             }
-            break;
-        }
-        case ChannelKind::Duration: {
-            outValue = value.toInt();
-            break;
-        }
-        case ChannelKind::SignalStrength: {
-            outValue = value.toInt();
-            break;
-        }
-        case ChannelKind::LinkQuality: {
-            const double raw = value.toDouble();
-            outValue = qBound(0.0, raw * binding.valueScale, 100.0);
-            break;
-        }
-        case ChannelKind::Motion: {
-            if (value.isBool()) {
-                outValue = value.toBool();
-            } else if (value.isString()) {
-                const QString state = value.toString().toLower();
-                outValue = (state == QStringLiteral("true")
-                            || state == QStringLiteral("on")
-                            || state == QStringLiteral("occupied"));
-            } else if (value.isDouble()) {
-                outValue = value.toDouble() != 0.0;
-            }
-            break;
-        }
-        case ChannelKind::Battery: {
-            outValue = value.toInt();
-            break;
-        }
-        case ChannelKind::ButtonEvent: {
-            if (value.isString()) {
-                const ButtonEventCode code = actionToButtonEvent(value.toString());
-                outValue = static_cast<int>(code);
+            if (code == static_cast<int>(ButtonEventCode::LongPressRelease)) {
+                runtime.lastEventCode = 0;
+                runtime.lastEventTs = 0;
+            } else {
+                runtime.lastEventCode = code;
+                runtime.lastEventTs = tsMs;
             }
-            break;
         }
-        case ChannelKind::Unknown: {
-            if (binding.dataType == ChannelDataType::Bool) {
-                if (value.isBool())
-                    outValue = value.toBool();
-                else if (value.isDouble())
-                    outValue = value.toDouble() != 0.0;
-                else if (value.isString())
-                    outValue = value.toString().toLower() == QStringLiteral("true");
-            } else if (binding.dataType == ChannelDataType::Int) {
-                outValue = value.toInt();
-            } else if (binding.dataType == ChannelDataType::Float) {
-                outValue = value.toDouble() * binding.valueScale;
-            } else if (binding.dataType == ChannelDataType::Enum) {
-                if (value.isString()) {
-                    const QString raw = value.toString();
-                    if (!binding.enumRawToValue.isEmpty()) {
-                        const auto it = binding.enumRawToValue.constFind(raw);
-                        if (it != binding.enumRawToValue.constEnd()) {
-                            outValue = it.value();
-                            break;
-                        }
-                    }
-                    outValue = raw;
-                } else if (value.isDouble()) {
-                    outValue = value.toInt();
+        emit channelStateUpdated(externalId, binding.channelId, outValue, tsMs);
+        if (binding.actionIsDial) {
+            runtime.lastDialValue = outValue.toInt();
+            m_timers.cancel(runtime.dialResetTimer);
+            runtime.dialResetTimer = m_timers.schedule(700, [this, externalId, channelId = binding.channelId]() {
+                Z2mDeviceEntry *current = nullptr;
+                const Z2mChannelBinding *currentBinding = nullptr;
+                if (!resolveChannel(externalId, channelId, current, currentBinding))
+                    return;
+                Z2mChannelRuntime &state = current->channelRuntime[currentBinding->index];
+                state.dialResetTimer = 0;
+                if (state.lastDialValue == 0)
+                    return;
+                emit channelStateUpdated(externalId, channelId, 0, QDateTime::currentMSecsSinceEpoch());
+                state.lastDialValue = 0;
+            });
+        } else if (binding.kind == ChannelKind::ButtonEvent) {
+            const int code = outValue.toInt();
+            if (code != static_cast<int>(ButtonEventCode::InitialPress)) {
+                runtime.multiPressCount = 0;
+                runtime.multiPressLastTs = 0;
+                if (code == static_cast<int>(ButtonEventCode::LongPressRelease)) {
+                    runtime.lastEventCode = 0;
+                    runtime.lastEventTs = 0;
                 }
+                m_timers.cancel(std::exchange(runtime.multiPressTimer, 0));
             }
-            break;
-        }
-        default:
-            break;
         }
+        return;
+    }
 
-        if (!outValue.isValid())
-            continue;
-        emit channelStateUpdated(externalId, binding.channelId, outValue, tsMs);
+    if (binding.decodeValue)
+        outValue = binding.decodeValue(binding, value);
+
+    if (!outValue.isValid())
+        return;
+    if (runtime.confirmCmdId)
+        confirmChannelState(entry, binding, outValue);
+    emitChannelState(entry, binding, outValue, tsMs);
+}
+
+QVariant Z2mAdapter::decodeOnOffValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    if (value.isBool())
+        return value.toBool();
+    if (value.isString()) {
+        const QString state = value.toString();
+        if (!binding.valueOn.isEmpty() || !binding.valueOff.isEmpty())
+            return state.compare(binding.valueOn, Qt::CaseInsensitive) == 0;
+        return state.compare(QStringLiteral("ON"), Qt::CaseInsensitive) == 0;
+    }
+    if (value.isDouble())
+        return value.toDouble() != 0.0;
+    return {};
+}
+
+QVariant Z2mAdapter::decodeBrightnessValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    return scaleToPercent(value.toDouble(), binding.rawMin, binding.rawMax);
+}
+
+QVariant Z2mAdapter::decodeDoubleValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    Q_UNUSED(binding);
+    return value.toDouble();
+}
+
+QVariant Z2mAdapter::decodeScaledValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    return value.toDouble() * binding.valueScale;
+}
+
+QVariant Z2mAdapter::decodeIntValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    Q_UNUSED(binding);
+    return value.toInt();
+}
+
+QVariant Z2mAdapter::decodeBoolValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    Q_UNUSED(binding);
+    if (value.isBool())
+        return value.toBool();
+    if (value.isDouble())
+        return value.toDouble() != 0.0;
+    if (value.isString())
+        return value.toString().toLower() == QStringLiteral("true");
+    return {};
+}
+
+QVariant Z2mAdapter::decodeEnumValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    if (value.isString()) {
+        const QString raw = value.toString();
+        const auto it = binding.enumRawToValue.constFind(raw);
+        if (it != binding.enumRawToValue.constEnd())
+            return it.value();
+        return raw;
+    }
+    if (value.isDouble())
+        return value.toInt();
+    return {};
+}
+
+QVariant Z2mAdapter::decodeColorValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    if (!value.isObject())
+        return {};
+    const QJsonObject colorObj = value.toObject();
+    if (binding.colorMode == QStringLiteral("xy")) {
+        const double x = colorObj.value(QStringLiteral("x")).toDouble();
+        const double y = colorObj.value(QStringLiteral("y")).toDouble();
+        return QVariant::fromValue(phicore::adapter::colorFromXy(x, y, 1.0));
+    }
+    if (binding.colorMode == QStringLiteral("hs")) {
+        const double h = colorObj.value(QStringLiteral("hue")).toDouble(colorObj.value(QStringLiteral("h")).toDouble());
+        const double s = colorObj.value(QStringLiteral("saturation")).toDouble(colorObj.value(QStringLiteral("s")).toDouble());
+        return QVariant::fromValue(phicore::adapter::hsvToColor(h, s / 100.0, 1.0));
+    }
+    return {};
+}
+
+QVariant Z2mAdapter::decodeLinkQualityValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    return qBound(0.0, value.toDouble() * binding.valueScale, 100.0);
+}
+
+QVariant Z2mAdapter::decodeMotionValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    Q_UNUSED(binding);
+    if (value.isBool())
+        return value.toBool();
+    if (value.isString()) {
+        const QString state = value.toString().toLower();
+        return state == QStringLiteral("true")
+            || state == QStringLiteral("on")
+            || state == QStringLiteral("occupied");
+    }
+    if (value.isDouble())
+        return value.toDouble() != 0.0;
+    return {};
+}
+
+QVariant Z2mAdapter::decodeButtonEventValue(const Z2mChannelBinding &binding, const QJsonValue &value)
+{
+    Q_UNUSED(binding);
+    if (!value.isString())
+        return {};
+    return static_cast<int>(actionToButtonEvent(value.toString()));
+}
+
+Z2mAdapter::Z2mChannelBinding::ValueDecoder Z2mAdapter::valueDecoderFor(const Z2mChannelBinding &binding)
+{
+    switch (binding.kind) {
+    case ChannelKind::PowerOnOff:
+        return &Z2mAdapter::decodeOnOffValue;
+    case ChannelKind::Brightness:
+        return &Z2mAdapter::decodeBrightnessValue;
+    case ChannelKind::ColorTemperature:
+        return &Z2mAdapter::decodeDoubleValue;
+    case ChannelKind::ColorRGB:
+        return &Z2mAdapter::decodeColorValue;
+    case ChannelKind::Temperature:
+    case ChannelKind::Humidity:
+    case ChannelKind::Illuminance:
+    case ChannelKind::CO2:
+    case ChannelKind::Power:
+    case ChannelKind::Voltage:
+    case ChannelKind::Current:
+    case ChannelKind::Energy:
+        return &Z2mAdapter::decodeScaledValue;
+    case ChannelKind::AmbientLightLevel:
+        return &Z2mAdapter::decodeEnumValue;
+    case ChannelKind::Duration:
+    case ChannelKind::SignalStrength:
+    case ChannelKind::Battery:
+        return &Z2mAdapter::decodeIntValue;
+    case ChannelKind::LinkQuality:
+        return &Z2mAdapter::decodeLinkQualityValue;
+    case ChannelKind::Motion:
+        return &Z2mAdapter::decodeMotionValue;
+    case ChannelKind::ButtonEvent:
+        return &Z2mAdapter::decodeButtonEventValue;
+    case ChannelKind::Unknown:
+        switch (binding.dataType) {
+        case ChannelDataType::Bool:
+            return &Z2mAdapter::decodeBoolValue;
+        case ChannelDataType::Int:
+            return &Z2mAdapter::decodeIntValue;
+        case ChannelDataType::Float:
+            return &Z2mAdapter::decodeScaledValue;
+        case ChannelDataType::Enum:
+            return &Z2mAdapter::decodeEnumValue;
+        default:
+            return nullptr;
+        }
+    default:
+        return nullptr;
     }
 }
 
-void Z2mAdapter::handleButtonShortPressRelease(const QString &pressKey,
-                                               const QString &externalId,
-                                               const QString &channelId,
+void Z2mAdapter::handleButtonShortPressRelease(Z2mDeviceEntry &entry,
+                                               const Z2mChannelBinding &binding,
                                                qint64 tsMs)
 {
-    if (pressKey.isEmpty() || externalId.isEmpty() || channelId.isEmpty())
-        return;
-
-    const qint64 lastTs = m_buttonMultiPressLastTs.value(pressKey, 0);
-    int count = m_buttonMultiPressCounts.value(pressKey, 0);
-    if (lastTs > 0 && (tsMs - lastTs) <= kButtonMultiPressWindowMs)
-        ++count;
+    Z2mChannelRuntime &runtime = entry.channelRuntime[binding.index];
+    if (runtime.multiPressLastTs > 0 && (tsMs - runtime.multiPressLastTs) <= kButtonMultiPressWindowMs)
+        ++runtime.multiPressCount;
     else
-        count = 1;
-
-    m_buttonMultiPressCounts.insert(pressKey, count);
-    m_buttonMultiPressLastTs.insert(pressKey, tsMs);
-
-    QTimer *timer = m_buttonMultiPressTimers.value(pressKey);
-    if (!timer) {
-        timer = new QTimer(this);
-        timer->setSingleShot(true);
-        m_buttonMultiPressTimers.insert(pressKey, timer);
-        connect(timer, &QTimer::timeout, this, [this, pressKey, externalId, channelId]() {
-            finalizePendingButtonShortPress(pressKey, externalId, channelId);
-        });
-    }
-    timer->start(kButtonMultiPressWindowMs);
+        runtime.multiPressCount = 1;
+    runtime.multiPressLastTs = tsMs;
+
+    m_timers.cancel(runtime.multiPressTimer);
+    runtime.multiPressTimer = m_timers.schedule(kButtonMultiPressWindowMs,
+                                                [this, externalId = entry.device.id, channelId = binding.channelId]() {
+        Z2mDeviceEntry *current = nullptr;
+        const Z2mChannelBinding *currentBinding = nullptr;
+        if (!resolveChannel(externalId, channelId, current, currentBinding))
+            return;
+        current->channelRuntime[currentBinding->index].multiPressTimer = 0;
+        finalizePendingButtonShortPress(*current, *currentBinding);
+    });
 }
 
-void Z2mAdapter::finalizePendingButtonShortPress(const QString &pressKey,
-                                                 const QString &externalId,
-                                                 const QString &channelId,
+void Z2mAdapter::finalizePendingButtonShortPress(Z2mDeviceEntry &entry,
+                                                 const Z2mChannelBinding &binding,
                                                  qint64 tsMs)
 {
-    const int count = m_buttonMultiPressCounts.value(pressKey, 0);
-    const qint64 lastTs = m_buttonMultiPressLastTs.value(pressKey, 0);
-    if (count <= 0) {
-        m_buttonMultiPressCounts.remove(pressKey);
-        m_buttonMultiPressLastTs.remove(pressKey);
+    Z2mChannelRuntime &runtime = entry.channelRuntime[binding.index];
+    const int count = runtime.multiPressCount;
+    const qint64 lastTs = runtime.multiPressLastTs;
+    runtime.multiPressCount = 0;
+    runtime.multiPressLastTs = 0;
+    if (count <= 0)
         return;
-    }
 
-    QTimer *timer = m_buttonMultiPressTimers.value(pressKey);
-    if (timer)
-        timer->stop();
+    m_timers.cancel(std::exchange(runtime.multiPressTimer, 0));
 
     const qint64 eventTs = tsMs > 0 ? tsMs : (lastTs > 0 ? lastTs : QDateTime::currentMSecsSinceEpoch());
-    if (count == 1) {
-        emit channelStateUpdated(externalId,
-                                 channelId,
-                                 static_cast<int>(ButtonEventCode::ShortPressRelease),
-                                 eventTs);
-        m_buttonMultiPressCounts.remove(pressKey);
-        m_buttonMultiPressLastTs.remove(pressKey);
-        return;
-    }
-
-    ButtonEventCode aggregated = ButtonEventCode::None;
+    ButtonEventCode aggregated = ButtonEventCode::ShortPressRelease;
     if (count == 2)
         aggregated = ButtonEventCode::DoublePress;
     else if (count == 3)
         aggregated = ButtonEventCode::TriplePress;
     else if (count == 4)
         aggregated = ButtonEventCode::QuadruplePress;
-    else
+    else if (count > 4)
         aggregated = ButtonEventCode::QuintuplePress;
 
-    emit channelStateUpdated(externalId,
-                             channelId,
+    emit channelStateUpdated(entry.device.id,
+                             binding.channelId,
                              static_cast<int>(aggregated),
                              eventTs);
-    m_buttonMultiPressCounts.remove(pressKey);
-    m_buttonMultiPressLastTs.remove(pressKey);
 }
 
 void Z2mAdapter::handleAvailabilityPayload(const QString &deviceId,
-                                           const QString &payload,
-                                           qint64 tsMs)
+                                           ConnectivityStatus status,
+                                           qint64 tsMs,
+                                           DeviceHandle handle)
 {
-    const auto deviceIt = m_devices.find(deviceId);
-    if (deviceIt == m_devices.end())
+    Z2mDeviceEntry *device = m_devices.get(handle);
+    if (!device)
+        device = findDeviceByName(deviceId);
+    if (!device)
         return;
-    const Z2mDeviceEntry &entry = deviceIt.value();
-    const QString externalId = entry.device.id;
-    for (auto it = entry.bindingsByChannel.begin(); it != entry.bindingsByChannel.end(); ++it) {
+    Z2mDeviceEntry &entry = *device;
+    for (auto it = entry.deviceTemplate->bindingsByChannel.cbegin();
+         it != entry.deviceTemplate->bindingsByChannel.cend();
+         ++it) {
         const Z2mChannelBinding &binding = it.value();
         if (!binding.isAvailability)
             continue;
-        const QString state = payload.trimmed().toLower();
-        ConnectivityStatus status = ConnectivityStatus::Unknown;
-        if (state == QStringLiteral("online"))
-            status = ConnectivityStatus::Connected;
-        else if (state == QStringLiteral("offline"))
-            status = ConnectivityStatus::Disconnected;
-        emit channelStateUpdated(externalId, binding.channelId,
-                                 static_cast<int>(status), tsMs);
+        emitChannelState(entry, binding, static_cast<int>(status), tsMs);
+        break;
+    }
+}
+
+void Z2mAdapter::emitChannelState(Z2mDeviceEntry &entry,
+                                  const Z2mChannelBinding &binding,
+                                  const QVariant &value,
+                                  qint64 tsMs,
+                                  bool force)
+{
+    // Button events are momentary, never deduplicated or replayed.
+    if (binding.kind == ChannelKind::ButtonEvent) {
+        emit channelStateUpdated(entry.device.id, binding.channelId, value, tsMs);
+        return;
+    }
+    Z2mChannelRuntime &runtime = entry.channelRuntime[binding.index];
+    // Compare against the last *emitted* value so slow drifts still get
+    // reported once they add up to more than the deadband.
+    if (!force && runtime.lastValue.isValid()) {
+        if (runtime.lastValue == value || isWithinDeadband(binding.kind, runtime.lastValue, value)) {
+            // Settled back to what was last sent; drop a pending trailing value.
+            runtime.hasPending = false;
+            runtime.pendingValue = QVariant();
+            return;
+        }
+    }
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (!force && binding.minEmitIntervalMs > 0) {
+        const qint64 elapsedMs = nowMs - runtime.lastEmitMs;
+        if (runtime.lastEmitMs > 0 && elapsedMs >= 0 && elapsedMs < binding.minEmitIntervalMs) {
+            runtime.pendingValue = value;
+            runtime.pendingTsMs = tsMs;
+            runtime.hasPending = true;
+            scheduleChannelFlush(entry, binding, static_cast<int>(binding.minEmitIntervalMs - elapsedMs));
+            return;
+        }
+    }
+    runtime.hasPending = false;
+    runtime.pendingValue = QVariant();
+    runtime.lastValue = value;
+    runtime.lastEmitMs = nowMs;
+    emit channelStateUpdated(entry.device.id, binding.channelId, value, tsMs);
+}
+
+void Z2mAdapter::scheduleChannelFlush(Z2mDeviceEntry &entry, const Z2mChannelBinding &binding, int delayMs)
+{
+    Z2mChannelRuntime &runtime = entry.channelRuntime[binding.index];
+    // Keep an armed timer: its deadline is the end of the current interval.
+    if (m_timers.isScheduled(runtime.flushTimer))
+        return;
+    runtime.flushTimer = m_timers.schedule(delayMs, [this, externalId = entry.device.id, channelId = binding.channelId]() {
+        flushPendingChannelState(externalId, channelId);
+    });
+}
+
+void Z2mAdapter::flushPendingChannelState(const QString &externalId, const QString &channelId)
+{
+    Z2mDeviceEntry *entry = nullptr;
+    const Z2mChannelBinding *binding = nullptr;
+    if (!resolveChannel(externalId, channelId, entry, binding))
+        return;
+    Z2mChannelRuntime &runtime = entry->channelRuntime[binding->index];
+    runtime.flushTimer = 0;
+    if (!runtime.hasPending)
+        return;
+    const QVariant value = std::exchange(runtime.pendingValue, QVariant());
+    runtime.hasPending = false;
+    // Already checked against the deadband when it was queued.
+    emitChannelState(*entry, *binding, value, runtime.pendingTsMs, true);
+}
+
+bool Z2mAdapter::resolveChannel(const QString &externalId,
+                                const QString &channelId,
+                                Z2mDeviceEntry *&entry,
+                                const Z2mChannelBinding *&binding)
+{
+    // Deferred callbacks re-resolve by id: the entry may have been rebuilt
+    // (new template, new indexes) or removed since they were scheduled.
+    Z2mDeviceEntry *device = findDeviceByExternalId(externalId);
+    if (!device)
+        return false;
+    const auto bindingIt = device->deviceTemplate->bindingsByChannel.constFind(channelId);
+    if (bindingIt == device->deviceTemplate->bindingsByChannel.cend())
+        return false;
+    entry = device;
+    binding = &bindingIt.value();
+    return true;
+}
+
+Z2mAdapter::DeviceHandle Z2mAdapter::deviceHandleFor(const QString &externalId) const
+{
+    // External ids are IEEE addresses, or friendly names for devices
+    // without one.
+    if (const quint64 ieee = parseIeeeAddress(externalId)) {
+        const auto it = m_deviceByIeee.constFind(ieee);
+        if (it != m_deviceByIeee.cend())
+            return it.value();
+    }
+    return m_deviceByName.value(externalId);
+}
+
+Z2mAdapter::Z2mDeviceEntry *Z2mAdapter::findDeviceByExternalId(const QString &externalId)
+{
+    return m_devices.get(deviceHandleFor(externalId));
+}
+
+Z2mAdapter::Z2mDeviceEntry *Z2mAdapter::findDeviceByName(const QString &mqttId)
+{
+    return m_devices.get(m_deviceByName.value(mqttId));
+}
+
+void Z2mAdapter::indexDevice(DeviceHandle handle, const QString &previousMqttId)
+{
+    const Z2mDeviceEntry *entry = m_devices.get(handle);
+    if (!entry)
+        return;
+    // Another device may already have taken the old name (e.g. two devices
+    // swapping names within one snapshot); only drop it if it is still ours.
+    if (!previousMqttId.isEmpty() && previousMqttId != entry->mqttId) {
+        const auto it = m_deviceByName.constFind(previousMqttId);
+        if (it != m_deviceByName.cend() && it.value() == handle)
+            m_deviceByName.erase(it);
+    }
+    m_deviceByName.insert(entry->mqttId, handle);
+    if (entry->ieee)
+        m_deviceByIeee.insert(entry->ieee, handle);
+}
+
+void Z2mAdapter::removeDevice(DeviceHandle handle)
+{
+    const Z2mDeviceEntry *entry = m_devices.get(handle);
+    if (!entry)
+        return;
+    const auto nameIt = m_deviceByName.constFind(entry->mqttId);
+    if (nameIt != m_deviceByName.cend() && nameIt.value() == handle)
+        m_deviceByName.erase(nameIt);
+    const auto ieeeIt = m_deviceByIeee.constFind(entry->ieee);
+    if (ieeeIt != m_deviceByIeee.cend() && ieeeIt.value() == handle)
+        m_deviceByIeee.erase(ieeeIt);
+    replaceTargetScenes(entry->device.id, {});
+    m_devices.remove(handle);
+}
+
+int Z2mAdapter::minEmitIntervalFor(const Z2mChannelBinding &binding, const Z2mDeviceTemplate &compiled) const
+{
+    if (binding.isAvailability
+        || binding.kind == ChannelKind::ButtonEvent
+        || binding.kind == ChannelKind::DeviceSoftwareUpdate) {
+        return 0;
+    }
+    if (!compiled.modelId.isEmpty() && m_minEmitIntervalMsByModelId.contains(compiled.modelId))
+        return m_minEmitIntervalMsByModelId.value(compiled.modelId);
+    if (!compiled.model.isEmpty() && m_minEmitIntervalMsByModel.contains(compiled.model))
+        return m_minEmitIntervalMsByModel.value(compiled.model);
+    return m_minEmitIntervalMsByKind.value(static_cast<int>(binding.kind), 0);
+}
+
+void Z2mAdapter::beginStateConfirmation(Z2mDeviceEntry &entry,
+                                        const Z2mChannelBinding &binding,
+                                        const QVariant &value,
+                                        CmdId cmdId,
+                                        qint64 sentMs)
+{
+    Z2mChannelRuntime &runtime = entry.channelRuntime[binding.index];
+    // A newer command overtakes the held one before its echo arrived; it
+    // can no longer be confirmed, so it is not reported as a success.
+    if (runtime.confirmCmdId && m_heldCommands.remove(runtime.confirmCmdId)) {
+        m_timers.cancel(runtime.confirmTimer);
+        CmdResponse superseded;
+        superseded.id = runtime.confirmCmdId;
+        superseded.tsMs = sentMs;
+        superseded.status = CmdStatus::Failure;
+        superseded.error = QStringLiteral("Superseded by a newer command before the device confirmed");
+        emit cmdResult(superseded);
+    }
+    m_heldCommands.insert(cmdId);
+    runtime.confirmCmdId = cmdId;
+    runtime.confirmValue = value;
+    runtime.confirmSentMs = sentMs;
+    const int timeoutMs = m_confirmTimeoutMsByKind.value(static_cast<int>(binding.kind), kConfirmTimeoutMs);
+    runtime.confirmTimer = m_timers.schedule(timeoutMs, [this, externalId = entry.device.id,
+                                                         channelId = binding.channelId, cmdId]() {
+        expireStateConfirmation(externalId, channelId, cmdId);
+    });
+}
+
+bool Z2mAdapter::cancelStateConfirmation(const QString &externalId, const QString &channelId, CmdId cmdId)
+{
+    // False if the command was already reported (confirmed, superseded or
+    // timed out).
+    if (!m_heldCommands.remove(cmdId))
+        return false;
+    Z2mDeviceEntry *entry = nullptr;
+    const Z2mChannelBinding *binding = nullptr;
+    if (resolveChannel(externalId, channelId, entry, binding)) {
+        Z2mChannelRuntime &runtime = entry->channelRuntime[binding->index];
+        if (runtime.confirmCmdId == cmdId) {
+            m_timers.cancel(std::exchange(runtime.confirmTimer, 0));
+            runtime.confirmCmdId = 0;
+            runtime.confirmValue.clear();
+        }
+    }
+    return true;
+}
+
+void Z2mAdapter::confirmChannelState(Z2mDeviceEntry &entry,
+                                     const Z2mChannelBinding &binding,
+                                     const QVariant &reported)
+{
+    Z2mChannelRuntime &runtime = entry.channelRuntime[binding.index];
+    // Intermediate values (e.g. during a transition) keep the command held.
+    if (!confirmationMatches(binding, runtime.confirmValue, reported))
+        return;
+    m_heldCommands.remove(runtime.confirmCmdId);
+    CmdResponse response;
+    response.id = std::exchange(runtime.confirmCmdId, 0);
+    response.tsMs = QDateTime::currentMSecsSinceEpoch();
+    response.status = CmdStatus::Success;
+    m_timers.cancel(std::exchange(runtime.confirmTimer, 0));
+    runtime.confirmValue.clear();
+    recordCommandLatency(entry, response.tsMs - runtime.confirmSentMs);
+    emit cmdResult(response);
+}
+
+void Z2mAdapter::expireStateConfirmation(const QString &externalId, const QString &channelId, CmdId cmdId)
+{
+    // The runtime slot may be gone (device removed or rebuilt with a new
+    // template); the held set still knows the command is unanswered.
+    if (!m_heldCommands.remove(cmdId))
+        return;
+    Z2mDeviceEntry *entry = nullptr;
+    const Z2mChannelBinding *binding = nullptr;
+    if (resolveChannel(externalId, channelId, entry, binding)) {
+        Z2mChannelRuntime &runtime = entry->channelRuntime[binding->index];
+        if (runtime.confirmCmdId == cmdId) {
+            runtime.confirmCmdId = 0;
+            runtime.confirmTimer = 0;
+            runtime.confirmValue.clear();
+        }
+    }
+    CmdResponse response;
+    response.id = cmdId;
+    response.tsMs = QDateTime::currentMSecsSinceEpoch();
+    response.status = CmdStatus::Timeout;
+    response.error = QStringLiteral("Device did not confirm the new state");
+    emit cmdResult(response);
+}
+
+void Z2mAdapter::recordCommandLatency(Z2mDeviceEntry &entry, qint64 latencyMs)
+{
+    Z2mLatencyStats &stats = entry.commandLatency;
+    latencyMs = qMax<qint64>(0, latencyMs);
+    stats.lastMs = latencyMs;
+    stats.averageMs = stats.samples == 0
+        ? static_cast<double>(latencyMs)
+        : stats.averageMs + (latencyMs - stats.averageMs) * kLatencySmoothing;
+    stats.maxMs = qMax(stats.maxMs, latencyMs);
+    ++stats.samples;
+
+    // The first sample is reported right away, later ones at most once per
+    // kLatencyReportIntervalMs.
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (stats.reportedMs != 0 && nowMs - stats.reportedMs < kLatencyReportIntervalMs)
+        return;
+    stats.reportedMs = nowMs;
+    QJsonObject latency;
+    latency.insert(QStringLiteral("last"), stats.lastMs);
+    latency.insert(QStringLiteral("average"), qRound64(stats.averageMs));
+    latency.insert(QStringLiteral("max"), stats.maxMs);
+    latency.insert(QStringLiteral("samples"), stats.samples);
+    entry.device.meta.insert(QStringLiteral("commandLatencyMs"), latency);
+    QJsonObject metaPatch;
+    metaPatch.insert(QStringLiteral("commandLatencyMs"), latency);
+    emit deviceMetaUpdated(entry.device.id, metaPatch);
+}
+
+bool Z2mAdapter::confirmationMatches(const Z2mChannelBinding &binding,
+                                     const QVariant &requested,
+                                     const QVariant &reported)
+{
+    switch (binding.dataType) {
+    case ChannelDataType::Color:
+        // Colors round-trip through the device's color space and never echo
+        // exactly; any report after the command counts.
+        return true;
+    case ChannelDataType::Bool:
+        return requested.toBool() == reported.toBool();
+    case ChannelDataType::Int:
+    case ChannelDataType::Float: {
+        bool requestedOk = false;
+        bool reportedOk = false;
+        const double requestedNumber = requested.toDouble(&requestedOk);
+        const double reportedNumber = reported.toDouble(&reportedOk);
+        if (!requestedOk || !reportedOk)
+            break;
+        // Scaled values (e.g. brightness percent <-> 0..254) may round.
+        const double tolerance = binding.dataType == ChannelDataType::Int
+            ? qMax(1.0, qAbs(requestedNumber) * 0.02)
+            : qMax(0.01, qAbs(requestedNumber) * 0.01);
+        return qAbs(requestedNumber - reportedNumber) <= tolerance;
+    }
+    default:
         break;
     }
+    return requested.toString().compare(reported.toString(), Qt::CaseInsensitive) == 0;
+}
+
+bool Z2mAdapter::isWithinDeadband(ChannelKind kind, const QVariant &previous, const QVariant &value) const
+{
+    const auto deadbandIt = m_channelDeadbands.constFind(static_cast<int>(kind));
+    if (deadbandIt == m_channelDeadbands.cend())
+        return false;
+    const auto isNumeric = [](const QVariant &v) {
+        switch (v.typeId()) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Float:
+        case QMetaType::Double:
+            return true;
+        default:
+            return false;
+        }
+    };
+    if (!isNumeric(previous) || !isNumeric(value))
+        return false;
+    const double prev = previous.toDouble();
+    const double threshold = std::max(deadbandIt.value().absolute,
+                                      deadbandIt.value().relative * qAbs(prev));
+    return qAbs(value.toDouble() - prev) <= threshold;
 }
 
 void Z2mAdapter::handleBridgeInfoPayload(const QJsonObject &payload, qint64 tsMs)
@@ -1801,14 +2516,13 @@ void Z2mAdapter::handleBridgeInfoPayload(const QJsonObject &payload, qint64 tsMs
         return;
     }
 
-    const QString coordinatorMqttId = m_mqttByExternal.value(m_coordinatorId, m_coordinatorId);
-    auto deviceIt = m_devices.find(coordinatorMqttId);
-    if (deviceIt == m_devices.end()) {
+    Z2mDeviceEntry *coordinatorEntry = findDeviceByExternalId(m_coordinatorId);
+    if (!coordinatorEntry) {
         m_pendingBridgeInfo = payload;
         return;
     }
 
-    Z2mDeviceEntry &entry = deviceIt.value();
+    Z2mDeviceEntry &entry = *coordinatorEntry;
     Device updated = entry.device;
     const QJsonObject coordinator = payload.value(QStringLiteral("coordinator")).toObject();
     const QJsonObject coordinatorMeta = coordinator.value(QStringLiteral("meta")).toObject();
@@ -1845,7 +2559,7 @@ void Z2mAdapter::handleBridgeInfoPayload(const QJsonObject &payload, qint64 tsMs
     const QString z2mCommit = payload.value(QStringLiteral("commit")).toString();
     updated.meta = meta;
     entry.device = updated;
-    emit deviceUpdated(entry.device, entry.channels);
+    emit deviceUpdated(entry.device, entry.deviceTemplate->channels);
 
     {
         QJsonObject metaPatch;
@@ -1895,11 +2609,12 @@ void Z2mAdapter::handleBridgeInfoPayload(const QJsonObject &payload, qint64 tsMs
     }
 
     if (m_mqttConnected && m_bridgeOnline) {
-        for (auto it = entry.bindingsByChannel.begin(); it != entry.bindingsByChannel.end(); ++it) {
+        for (auto it = entry.deviceTemplate->bindingsByChannel.cbegin();
+             it != entry.deviceTemplate->bindingsByChannel.cend();
+             ++it) {
             if (!it.value().isAvailability)
                 continue;
-            emit channelStateUpdated(m_coordinatorId, it.value().channelId,
-                                     static_cast<int>(ConnectivityStatus::Connected), tsMs);
+            emitChannelState(entry, it.value(), static_cast<int>(ConnectivityStatus::Connected), tsMs);
             break;
         }
     }
@@ -1914,14 +2629,223 @@ void Z2mAdapter::handleBridgeInfoPayload(const QJsonObject &payload, qint64 tsMs
         const QString targetVersion = updateObj.value(QStringLiteral("version")).toString();
         if (!targetVersion.isEmpty())
             updatePayload.insert(QStringLiteral("targetVersion"), targetVersion);
-        const auto updateIt = entry.bindingsByChannel.constFind(QStringLiteral("device_software_update"));
-        if (updateIt != entry.bindingsByChannel.constEnd()) {
-            emit channelStateUpdated(m_coordinatorId, updateIt.value().channelId, updatePayload, tsMs);
+        const auto updateIt = entry.deviceTemplate->bindingsByChannel.constFind(QStringLiteral("device_software_update"));
+        if (updateIt != entry.deviceTemplate->bindingsByChannel.constEnd()) {
+            emitChannelState(entry, updateIt.value(), updatePayload, tsMs);
+        }
+    }
+}
+
+void Z2mAdapter::handleBridgeGroupsPayload(const QJsonArray &groups)
+{
+    // bridge/groups is always the complete list.
+    QSet<QString> seen;
+    for (const QJsonValue &value : groups) {
+        const QJsonObject obj = value.toObject();
+        const int z2mId = obj.value(QStringLiteral("id")).toInt(-1);
+        const QString mqttId = obj.value(QStringLiteral("friendly_name")).toString().trimmed();
+        if (z2mId < 0 || mqttId.isEmpty())
+            continue;
+
+        Group group;
+        group.id = QStringLiteral("group:%1").arg(z2mId);
+        group.name = mqttId;
+        QJsonArray members;
+        const QJsonArray rawMembers = obj.value(QStringLiteral("members")).toArray();
+        for (const QJsonValue &memberValue : rawMembers) {
+            const QJsonObject member = memberValue.toObject();
+            const QString ieeeAddress = member.value(QStringLiteral("ieee_address")).toString().trimmed();
+            if (ieeeAddress.isEmpty())
+                continue;
+            // Device external ids are IEEE addresses; a device may be a
+            // member with several endpoints.
+            if (!group.deviceExternalIds.contains(ieeeAddress))
+                group.deviceExternalIds.append(ieeeAddress);
+            members.append(member);
+        }
+        group.meta.insert(QStringLiteral("z2mGroupId"), z2mId);
+        group.meta.insert(QStringLiteral("friendly_name"), mqttId);
+        group.meta.insert(QStringLiteral("members"), members);
+        const QString description = obj.value(QStringLiteral("description")).toString();
+        if (!description.isEmpty())
+            group.meta.insert(QStringLiteral("description"), description);
+
+        seen.insert(group.id);
+        QList<Z2mSceneEntry> scenes;
+        collectScenes(obj.value(QStringLiteral("scenes")).toArray(), group.id, QStringLiteral("group"),
+                      QString(), scenes);
+        replaceTargetScenes(group.id, std::move(scenes));
+
+        auto it = m_groups.find(group.id);
+        if (it != m_groups.end() && it->mqttId == mqttId && it->group.name == group.name
+            && it->group.deviceExternalIds == group.deviceExternalIds && it->group.meta == group.meta) {
+            continue;
         }
+        Z2mGroupEntry entry;
+        entry.group = group;
+        entry.mqttId = mqttId;
+        m_groups.insert(group.id, std::move(entry));
+        emit groupUpdated(group);
     }
+
+    for (auto it = m_groups.begin(); it != m_groups.end();) {
+        if (seen.contains(it.key())) {
+            ++it;
+            continue;
+        }
+        emit groupRemoved(it.key());
+        replaceTargetScenes(it.key(), {});
+        it = m_groups.erase(it);
+    }
+}
+
+void Z2mAdapter::handleNetworkMapPayload(const QJsonObject &response)
+{
+    // Only consumed when someone (usually the Z2M frontend) requested a raw
+    // map; a scan loads the whole mesh, so the adapter never starts one.
+    const QJsonObject data = response.value(QStringLiteral("data")).toObject();
+    if (data.value(QStringLiteral("type")).toString() != QStringLiteral("raw"))
+        return;
+    const QJsonArray links = data.value(QStringLiteral("value")).toObject().value(QStringLiteral("links")).toArray();
+    if (links.isEmpty())
+        return;
+
+    // Links are neighbor table entries: relationship is what source is to
+    // target (0 parent, 1 child).
+    QHash<QString, QString> parents;
+    for (const QJsonValue &value : links) {
+        const QJsonObject link = value.toObject();
+        const QString source = link.value(QStringLiteral("source")).toObject()
+                                   .value(QStringLiteral("ieeeAddr")).toString();
+        const QString target = link.value(QStringLiteral("target")).toObject()
+                                   .value(QStringLiteral("ieeeAddr")).toString();
+        if (source.isEmpty() || target.isEmpty() || source == target)
+            continue;
+        const int relationship = link.value(QStringLiteral("relationship")).toInt(-1);
+        if (relationship == 0)
+            parents.insert(target, source);
+        else if (relationship == 1)
+            parents.insert(source, target);
+    }
+    m_pacer.setParents(std::move(parents));
+}
+
+const Z2mAdapter::Z2mChannelBinding *Z2mAdapter::groupCommandBinding(const Z2mGroupEntry &group,
+                                                                     const QString &channelId)
+{
+    // Members share channel ids for common exposes; encode with the first
+    // member that can take the command. Endpoint-specific properties
+    // ("state_l1") have no meaning on a group topic.
+    for (const QString &memberId : group.group.deviceExternalIds) {
+        const Z2mDeviceEntry *member = findDeviceByExternalId(memberId);
+        if (!member)
+            continue;
+        const auto it = member->deviceTemplate->bindingsByChannel.constFind(channelId);
+        if (it == member->deviceTemplate->bindingsByChannel.cend())
+            continue;
+        if (it->endpoint.isEmpty() && it->flags.testFlag(ChannelFlag::ChannelFlagWritable))
+            return &it.value();
+    }
+    return nullptr;
+}
+
+void Z2mAdapter::updateGroupChannelState(const Z2mGroupEntry &group,
+                                         const QString &channelExternalId,
+                                         const QVariant &value,
+                                         CmdId cmdId)
+{
+    CmdResponse response;
+    response.id = cmdId;
+    response.tsMs = QDateTime::currentMSecsSinceEpoch();
+
+    const Z2mChannelBinding *binding = groupCommandBinding(group, channelExternalId);
+    if (!binding) {
+        response.status = CmdStatus::NotSupported;
+        response.error = QStringLiteral("No group member accepts this channel");
+        emit cmdResult(response);
+        return;
+    }
+
+    if (!m_connected || !m_client || m_client->state() != ::phicore::MqttClient::State::Connected) {
+        response.status = CmdStatus::TemporarilyOffline;
+        response.error = QStringLiteral("MQTT broker not connected");
+        emit cmdResult(response);
+        return;
+    }
+
+    QJsonObject payload;
+    QString errorString;
+    if (!buildCommandPayload(group.group.id, *binding, value, payload, errorString)) {
+        response.status = CmdStatus::InvalidArgument;
+        response.error = errorString;
+        emit cmdResult(response);
+        return;
+    }
+
+    // One publish to the group topic; Z2M sends a single Zigbee multicast
+    // and publishes the members' (optimistic) state on its own, so there is
+    // no post-set refresh and no per-member state confirmation.
+    publishPacedCommand(group.group.id, group.mqttId, payload, QString(), response);
+}
+
+void Z2mAdapter::collectScenes(const QJsonArray &rawScenes,
+                               const QString &targetId,
+                               const QString &scopeType,
+                               const QString &endpoint,
+                               QList<Z2mSceneEntry> &out)
+{
+    for (const QJsonValue &value : rawScenes) {
+        const QJsonObject obj = value.toObject();
+        const int z2mSceneId = obj.value(QStringLiteral("id")).toInt(-1);
+        if (z2mSceneId < 0)
+            continue;
+        Z2mSceneEntry entry;
+        entry.targetId = targetId;
+        entry.endpoint = endpoint;
+        entry.z2mSceneId = z2mSceneId;
+        entry.scene.id = endpoint.isEmpty()
+            ? QStringLiteral("%1/scene/%2").arg(targetId).arg(z2mSceneId)
+            : QStringLiteral("%1/%2/scene/%3").arg(targetId, endpoint).arg(z2mSceneId);
+        entry.scene.name = obj.value(QStringLiteral("name")).toString().trimmed();
+        if (entry.scene.name.isEmpty())
+            entry.scene.name = QStringLiteral("Scene %1").arg(z2mSceneId);
+        entry.scene.scopeId = targetId;
+        entry.scene.scopeType = scopeType;
+        entry.scene.flags = SceneFlag::SceneFlagOriginAdapter;
+        entry.scene.meta.insert(QStringLiteral("z2mSceneId"), z2mSceneId);
+        if (!endpoint.isEmpty())
+            entry.scene.meta.insert(QStringLiteral("endpoint"), endpoint);
+        out.append(std::move(entry));
+    }
+}
+
+void Z2mAdapter::replaceTargetScenes(const QString &targetId, QList<Z2mSceneEntry> scenes)
+{
+    // The interface has no scene removal; vanished scenes are only dropped
+    // here, so recalling them fails instead of publishing stale ids.
+    QStringList ids;
+    QList<Scene> changed;
+    for (Z2mSceneEntry &entry : scenes) {
+        ids.append(entry.scene.id);
+        const auto it = m_scenes.constFind(entry.scene.id);
+        if (it != m_scenes.cend() && it->scene.name == entry.scene.name && it->scene.meta == entry.scene.meta)
+            continue;
+        changed.append(entry.scene);
+        m_scenes.insert(entry.scene.id, std::move(entry));
+    }
+    for (const QString &id : m_sceneIdsByTarget.value(targetId)) {
+        if (!ids.contains(id))
+            m_scenes.remove(id);
+    }
+    if (ids.isEmpty())
+        m_sceneIdsByTarget.remove(targetId);
+    else
+        m_sceneIdsByTarget.insert(targetId, ids);
+    if (!changed.isEmpty())
+        emit scenesUpdated(changed);
 }
 
-Z2mAdapter::Z2mDeviceEntry Z2mAdapter::buildDeviceEntry(const QJsonObject &obj) const
+Z2mAdapter::Z2mDeviceEntry Z2mAdapter::buildDeviceEntry(const QJsonObject &obj)
 {
     Z2mDeviceEntry entry;
     const QString mqttId = obj.value(QStringLiteral("friendly_name")).toString().trimmed();
@@ -1965,6 +2889,7 @@ Z2mAdapter::Z2mDeviceEntry Z2mAdapter::buildDeviceEntry(const QJsonObject &obj)
     if (!dateCode.isEmpty())
         entry.device.meta.insert(QStringLiteral("date_code"), dateCode);
     entry.device.id = !ieeeAddress.isEmpty() ? ieeeAddress : mqttId;
+    entry.ieee = parseIeeeAddress(ieeeAddress);
     if (deviceType.compare(QStringLiteral("Coordinator"), Qt::CaseInsensitive) == 0) {
         entry.device.deviceClass = DeviceClass::Gateway;
         entry.device.meta.insert(QStringLiteral("coordinator"), true);
@@ -1984,15 +2909,56 @@ Z2mAdapter::Z2mDeviceEntry Z2mAdapter::buildDeviceEntry(const QJsonObject &obj)
     if (!availabilityState.isEmpty())
         entry.device.meta.insert(QStringLiteral("availability"), availabilityState);
 
+    entry.deviceTemplate = deviceTemplateFor(def, modelId);
+    entry.device.deviceClass = entry.deviceTemplate->deviceClass;
+    entry.channelRuntime.resize(entry.deviceTemplate->bindingsByChannel.size());
+
+    return entry;
+}
+
+std::shared_ptr<const Z2mAdapter::Z2mDeviceTemplate> Z2mAdapter::deviceTemplateFor(const QJsonObject &definition,
+                                                                                const QString &modelId)
+{
+    const QString model = definition.value(QStringLiteral("model")).toString().trimmed();
+    const QString key = QStringLiteral("%1\x1f%2\x1f%3")
+        .arg(model, modelId.trimmed(), QString::number(qHash(definition), 16));
+    const auto it = m_deviceTemplates.constFind(key);
+    if (it != m_deviceTemplates.constEnd())
+        return it.value();
+    auto compiled = std::make_shared<const Z2mDeviceTemplate>(compileDeviceTemplate(definition, model, modelId.trimmed()));
+    m_deviceTemplates.insert(key, compiled);
+    return compiled;
+}
+
+void Z2mAdapter::pruneDeviceTemplates()
+{
+    auto it = m_deviceTemplates.begin();
+    while (it != m_deviceTemplates.end()) {
+        if (it.value().use_count() == 1)
+            it = m_deviceTemplates.erase(it);
+        else
+            ++it;
+    }
+}
+
+Z2mAdapter::Z2mDeviceTemplate Z2mAdapter::compileDeviceTemplate(const QJsonObject &definition,
+                                                                const QString &model,
+                                                                const QString &modelId) const
+{
+    Z2mDeviceTemplate compiled;
+    compiled.model = model;
+    compiled.modelId = modelId;
+    compiled.propertyScope = m_propertyFilter.scopeFor(model, modelId);
+
     QList<QJsonObject> exposes;
-    if (def.contains(QStringLiteral("exposes"))) {
-        collectExposeEntries(def.value(QStringLiteral("exposes")), exposes);
+    if (definition.contains(QStringLiteral("exposes"))) {
+        collectExposeEntries(definition.value(QStringLiteral("exposes")), exposes);
     }
 
-    entry.device.deviceClass = inferDeviceClass(exposes);
+    compiled.deviceClass = inferDeviceClass(exposes);
 
     for (const QJsonObject &expose : exposes) {
-        addChannelFromExpose(expose, entry);
+        addChannelFromExpose(expose, compiled);
     }
 
     Channel availability;
@@ -2003,7 +2969,7 @@ Z2mAdapter::Z2mDeviceEntry Z2mAdapter::buildDeviceEntry(const QJsonObject &obj)
     availability.flags = ChannelFlag::ChannelFlagReadable
         | ChannelFlag::ChannelFlagReportable
         | ChannelFlag::ChannelFlagRetained;
-    entry.channels.push_back(availability);
+    compiled.channels.push_back(availability);
 
     Z2mChannelBinding availabilityBinding;
     availabilityBinding.channelId = availability.id;
@@ -2012,8 +2978,8 @@ Z2mAdapter::Z2mDeviceEntry Z2mAdapter::buildDeviceEntry(const QJsonObject &obj)
     availabilityBinding.dataType = availability.dataType;
     availabilityBinding.flags = availability.flags;
     availabilityBinding.isAvailability = true;
-    entry.bindingsByChannel.insert(availability.id, availabilityBinding);
-    entry.channelByProperty.insert(availabilityBinding.property, availability.id);
+    compiled.bindingsByChannel.insert(availability.id, availabilityBinding);
+    compiled.channelByProperty.insert(availabilityBinding.property, availability.id);
 
     Channel updateChannel;
     updateChannel.id = QStringLiteral("device_software_update");
@@ -2021,7 +2987,7 @@ Z2mAdapter::Z2mDeviceEntry Z2mAdapter::buildDeviceEntry(const QJsonObject &obj)
     updateChannel.kind = ChannelKind::DeviceSoftwareUpdate;
     updateChannel.dataType = ChannelDataType::Enum;
     updateChannel.flags = ChannelFlagDefaultRead;
-    entry.channels.push_back(updateChannel);
+    compiled.channels.push_back(updateChannel);
 
     Z2mChannelBinding updateBinding;
     updateBinding.channelId = updateChannel.id;
@@ -2029,12 +2995,17 @@ Z2mAdapter::Z2mDeviceEntry Z2mAdapter::buildDeviceEntry(const QJsonObject &obj)
     updateBinding.kind = updateChannel.kind;
     updateBinding.dataType = updateChannel.dataType;
     updateBinding.flags = updateChannel.flags;
-    entry.bindingsByChannel.insert(updateChannel.id, updateBinding);
+    compiled.bindingsByChannel.insert(updateChannel.id, updateBinding);
+    compiled.channelByProperty.insert(updateBinding.property, updateChannel.id);
 
-    for (const Channel &channel : entry.channels) {
+    int bindingIndex = 0;
+    for (auto it = compiled.bindingsByChannel.begin(); it != compiled.bindingsByChannel.end(); ++it) {
+        it.value().index = bindingIndex++;
+        it.value().decodeValue = valueDecoderFor(it.value());
+        it.value().minEmitIntervalMs = minEmitIntervalFor(it.value(), compiled);
     }
 
-    return entry;
+    return compiled;
 }
 
 void Z2mAdapter::collectExposeEntries(const QJsonValue &value, QList<QJsonObject> &out) const
@@ -2062,7 +3033,7 @@ void Z2mAdapter::collectExposeEntries(const QJsonValue &value, QList<QJsonObject
     }
 }
 
-void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry &entry) const
+void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceTemplate &compiled) const
 {
     const auto channelIdForProperty = [](const QString &property, const QString &endpoint) {
         if (endpoint.isEmpty())
@@ -2084,7 +3055,7 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
     const QString property = expose.value(QStringLiteral("property")).toString().trimmed();
     if (property.isEmpty())
         return;
-    if (isPropertySuppressed(property, entry))
+    if (isPropertySuppressed(property, compiled))
         return;
     const QString propLower = property.toLower();
     const bool isMinMaxHelper =
@@ -2111,7 +3082,7 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
     }
 
     const QString channelId = channelIdForProperty(property, endpoint);
-    if (entry.bindingsByChannel.contains(channelId))
+    if (compiled.bindingsByChannel.contains(channelId))
         return;
 
     struct Mapping {
@@ -2157,18 +3128,19 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
         const int access = expose.value(QStringLiteral("access")).toInt(kAccessState);
         const ChannelFlags flags = flagsFromAccess(access);
         const QJsonArray values = expose.value(QStringLiteral("values")).toArray();
-        QStringList actionValues;
-        actionValues.reserve(values.size());
         bool hasDial = false;
+        QSet<int> buttonIds;
         for (const QJsonValue &val : values) {
-            const QString action = val.toString().trimmed();
-            if (action.isEmpty())
+            const QString rawAction = val.toString();
+            if (rawAction.trimmed().isEmpty())
                 continue;
-            actionValues.push_back(action);
-            if (isDialAction(action))
+            const Z2mActionInfo info = compileAction(rawAction);
+            compiled.actionVocabulary.insert(rawAction, info);
+            if (info.isDial)
                 hasDial = true;
+            if (info.buttonId > 0)
+                buttonIds.insert(info.buttonId);
         }
-        const QSet<int> buttonIds = extractActionButtonIds(actionValues);
         if (buttonIds.isEmpty()) {
             Channel button;
             button.id = channelId;
@@ -2177,7 +3149,7 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
             button.kind = ChannelKind::ButtonEvent;
             button.dataType = ChannelDataType::Int;
             button.flags = flags;
-            entry.channels.push_back(button);
+            compiled.channels.push_back(button);
 
             Z2mChannelBinding binding;
             binding.channelId = button.id;
@@ -2186,8 +3158,8 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
             binding.dataType = button.dataType;
             binding.flags = button.flags;
             binding.endpoint = endpoint;
-            entry.bindingsByChannel.insert(button.id, binding);
-            entry.channelByProperty.insert(property, button.id);
+            compiled.bindingsByChannel.insert(button.id, binding);
+            compiled.channelByProperty.insert(property, button.id);
         } else {
             QList<int> sortedButtonIds = buttonIds.values();
             std::sort(sortedButtonIds.begin(), sortedButtonIds.end());
@@ -2200,7 +3172,7 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
                 button.kind = ChannelKind::ButtonEvent;
                 button.dataType = ChannelDataType::Int;
                 button.flags = flags;
-                entry.channels.push_back(button);
+                compiled.channels.push_back(button);
 
                 Z2mChannelBinding binding;
                 binding.channelId = button.id;
@@ -2210,8 +3182,8 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
                 binding.flags = button.flags;
                 binding.endpoint = endpoint;
                 binding.actionButtonId = buttonId;
-                entry.bindingsByChannel.insert(button.id, binding);
-                entry.channelByProperty.insert(property, button.id);
+                compiled.bindingsByChannel.insert(button.id, binding);
+                compiled.channelByProperty.insert(property, button.id);
             }
         }
         if (hasDial) {
@@ -2223,7 +3195,7 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
             dial.kind = ChannelKind::RelativeRotation;
             dial.dataType = ChannelDataType::Int;
             dial.flags = flags;
-            entry.channels.push_back(dial);
+            compiled.channels.push_back(dial);
 
             Z2mChannelBinding dialBinding;
             dialBinding.channelId = dial.id;
@@ -2233,8 +3205,8 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
             dialBinding.flags = dial.flags;
             dialBinding.endpoint = endpoint;
             dialBinding.actionIsDial = true;
-            entry.bindingsByChannel.insert(dial.id, dialBinding);
-            entry.channelByProperty.insert(property, dial.id);
+            compiled.bindingsByChannel.insert(dial.id, dialBinding);
+            compiled.channelByProperty.insert(property, dial.id);
         }
         return;
     }
@@ -2264,7 +3236,7 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
     const int access = expose.value(QStringLiteral("access")).toInt(kAccessState);
     channel.flags = flagsFromAccess(access);
 
-    if (entry.device.deviceClass == DeviceClass::Sensor) {
+    if (compiled.deviceClass == DeviceClass::Sensor) {
         const auto isSensorMeasurementKind = [](ChannelKind kind) {
             switch (kind) {
             case ChannelKind::Temperature:
@@ -2436,7 +3408,7 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
             channel.stepValue = channel.stepValue / 1000.0;
     }
 
-    entry.channels.push_back(channel);
+    compiled.channels.push_back(channel);
 
     Z2mChannelBinding binding;
     binding.channelId = channelId;
@@ -2494,31 +3466,13 @@ void Z2mAdapter::addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry
             binding.colorMode = QStringLiteral("xy");
     }
 
-    entry.bindingsByChannel.insert(channelId, binding);
-    entry.channelByProperty.insert(property, channelId);
+    compiled.bindingsByChannel.insert(channelId, binding);
+    compiled.channelByProperty.insert(property, channelId);
 }
 
-bool Z2mAdapter::isPropertySuppressed(const QString &property, const Z2mDeviceEntry &entry) const
+bool Z2mAdapter::isPropertySuppressed(const QString &property, const Z2mDeviceTemplate &compiled) const
 {
-    bool suppressed = startsWithAnyPrefix(property, m_suppressedPropertyPrefixes);
-
-    const QString model = entry.device.model.trimmed();
-    if (!model.isEmpty()) {
-        suppressed = suppressed
-            || startsWithAnyPrefix(property, m_suppressedPropertyPrefixesByModel.value(model));
-        if (startsWithAnyPrefix(property, m_allowedPropertyPrefixesByModel.value(model)))
-            suppressed = false;
-    }
-
-    const QString modelId = entry.device.meta.value(QStringLiteral("model_id")).toString().trimmed();
-    if (!modelId.isEmpty()) {
-        suppressed = suppressed
-            || startsWithAnyPrefix(property, m_suppressedPropertyPrefixesByModelId.value(modelId));
-        if (startsWithAnyPrefix(property, m_allowedPropertyPrefixesByModelId.value(modelId)))
-            suppressed = false;
-    }
-
-    return suppressed;
+    return m_propertyFilter.isSuppressed(property, compiled.propertyScope);
 }
 
 ChannelFlags Z2mAdapter::flagsFromAccess(int access) const
@@ -2596,7 +3550,23 @@ DeviceClass Z2mAdapter::inferDeviceClass(const QList<QJsonObject> &exposes) cons
     return DeviceClass::Unknown;
 }
 
-ButtonEventCode Z2mAdapter::actionToButtonEvent(const QString &action) const
+Z2mAdapter::Z2mActionInfo Z2mAdapter::compileAction(const QString &rawAction)
+{
+    Z2mActionInfo info;
+    info.normalized = rawAction.trimmed().toLower();
+    if (info.normalized.isEmpty())
+        return info;
+    const QStringList tokens = actionTokens(info.normalized);
+    info.buttonId = actionButtonIdFromTokens(tokens);
+    info.code = actionToButtonEvent(info.normalized);
+    info.isScene = info.normalized.startsWith(QStringLiteral("scene_"));
+    info.isDial = isDialActionName(info.normalized);
+    info.dialDirection = dialDirectionFromTokens(tokens);
+    info.dialMagnitude = dialMagnitudeFromTokens(tokens);
+    return info;
+}
+
+ButtonEventCode Z2mAdapter::actionToButtonEvent(const QString &action)
 {
     const QString value = action.toLower();
     if (value.contains(QStringLiteral("double")))
@@ -2620,27 +3590,163 @@ ButtonEventCode Z2mAdapter::actionToButtonEvent(const QString &action) const
     return ButtonEventCode::None;
 }
 
-bool Z2mAdapter::publishCommand(const QString &deviceId,
-                                const QJsonObject &payload,
-                                const QString &endpoint,
-                                QString &errorString)
+::phicore::MqttClient::PublishId Z2mAdapter::publishCommand(const QString &deviceId,
+                                                            const QJsonObject &payload,
+                                                            const QString &endpoint,
+                                                            QString &errorString)
 {
     if (!m_client || m_client->state() != ::phicore::MqttClient::State::Connected) {
         errorString = QStringLiteral("MQTT client not connected.");
-        return false;
+        return 0;
     }
     QJsonDocument doc(payload);
     const QString topic = endpoint.isEmpty()
         ? QStringLiteral("%1/%2/set").arg(m_baseTopic, deviceId)
         : QStringLiteral("%1/%2/%3/set").arg(m_baseTopic, deviceId, endpoint);
-    const qint32 msgId = m_client->publish(topic, doc.toJson(QJsonDocument::Compact));
-    if (msgId < 0) {
+    const ::phicore::MqttClient::PublishId publishId =
+        m_client->publish(topic, doc.toJson(QJsonDocument::Compact));
+    if (!publishId) {
         errorString = QStringLiteral("MQTT publish failed.");
-        return false;
+        return 0;
     }
+    return publishId;
+}
+
+void Z2mAdapter::publishPacedCommand(const QString &lane,
+                                     const QString &mqttId,
+                                     const QJsonObject &payload,
+                                     const QString &endpoint,
+                                     CmdResponse response)
+{
+    m_pacer.enqueue(lane, Z2mCommandPacer::Priority::Command,
+                    [this, mqttId, payload, endpoint, response](bool send) mutable {
+        if (!send) {
+            response.tsMs = QDateTime::currentMSecsSinceEpoch();
+            response.status = CmdStatus::TemporarilyOffline;
+            response.error = QStringLiteral("Adapter stopped before the command was sent");
+            emit cmdResult(response);
+            return;
+        }
+        QString errorString;
+        const ::phicore::MqttClient::PublishId publishId =
+            publishCommand(mqttId, payload, endpoint, errorString);
+        if (!publishId) {
+            response.tsMs = QDateTime::currentMSecsSinceEpoch();
+            response.status = CmdStatus::Failure;
+            response.error = errorString;
+            emit cmdResult(response);
+            return;
+        }
+        awaitPublish(publishId, [this, response](bool ok) mutable {
+            response.tsMs = QDateTime::currentMSecsSinceEpoch();
+            if (ok) {
+                response.status = CmdStatus::Success;
+            } else {
+                response.status = CmdStatus::Failure;
+                response.error = QStringLiteral("MQTT publish failed.");
+            }
+            emit cmdResult(response);
+        });
+    });
+}
+
+void Z2mAdapter::awaitPublish(::phicore::MqttClient::PublishId publishId, std::function<void(bool ok)> done)
+{
+    if (!publishId || !done)
+        return;
+    m_publishWaiters.insert(publishId, std::move(done));
+}
+
+// Publishes <base>/bridge/request/<request> with a unique "transaction" and
+// calls done once with the matching bridge/response, on timeout, or when
+// the publish fails (then before returning). Returns the transaction id,
+// empty if done already ran.
+QString Z2mAdapter::bridgeRequest(const QString &request, QJsonObject payload, BridgeCallback done)
+{
+    if (!m_client || m_client->state() != ::phicore::MqttClient::State::Connected) {
+        done(CmdStatus::TemporarilyOffline, {}, QStringLiteral("MQTT broker not connected"));
+        return {};
+    }
+    // Random per adapter instance so responses to another client (or an
+    // earlier run) with the same counter are never mistaken for ours.
+    if (m_transactionPrefix.isEmpty())
+        m_transactionPrefix = QStringLiteral("phi-%1-").arg(QRandomGenerator::global()->generate(), 8, 16, QLatin1Char('0'));
+    const QString transaction = m_transactionPrefix + QString::number(++m_nextTransaction);
+    payload.insert(QStringLiteral("transaction"), transaction);
+
+    const QString topic = QStringLiteral("%1/bridge/request/%2").arg(m_baseTopic, request);
+    const ::phicore::MqttClient::PublishId publishId =
+        m_client->publish(topic, QJsonDocument(payload).toJson(QJsonDocument::Compact));
+    if (!publishId) {
+        done(CmdStatus::Failure, {}, QStringLiteral("MQTT publish failed."));
+        return {};
+    }
+
+    PendingBridgeRequest &pending = m_bridgeRequests[transaction];
+    pending.done = std::move(done);
+    pending.timeout = m_timers.schedule(kBridgeRequestTimeoutMs, [this, transaction]() {
+        resolveBridgeRequest(transaction, CmdStatus::Timeout, {}, QStringLiteral("No response from Z2M bridge"));
+    });
+    awaitPublish(publishId, [this, transaction](bool ok) {
+        if (!ok)
+            resolveBridgeRequest(transaction, CmdStatus::Failure, {}, QStringLiteral("MQTT publish failed."));
+    });
+    return transaction;
+}
+
+bool Z2mAdapter::resolveBridgeRequest(const QString &transaction,
+                                      CmdStatus status,
+                                      const QJsonObject &response,
+                                      const QString &error)
+{
+    const auto it = m_bridgeRequests.find(transaction);
+    if (it == m_bridgeRequests.end())
+        return false;
+    const PendingBridgeRequest pending = std::move(it.value());
+    m_bridgeRequests.erase(it);
+    m_timers.cancel(pending.timeout);
+    pending.done(status, response, error);
     return true;
 }
 
+void Z2mAdapter::handleBridgeResponse(const QJsonObject &response)
+{
+    // Responses to requests of other clients carry their own (or no)
+    // transaction and are ignored.
+    const QString transaction = response.value(QStringLiteral("transaction")).toString();
+    if (transaction.isEmpty() || !transaction.startsWith(m_transactionPrefix))
+        return;
+    const QString status = response.value(QStringLiteral("status")).toString().trimmed();
+    if (status.compare(QStringLiteral("ok"), Qt::CaseInsensitive) == 0) {
+        resolveBridgeRequest(transaction, CmdStatus::Success, response);
+        return;
+    }
+    QString error = response.value(QStringLiteral("error")).toString().trimmed();
+    if (error.isEmpty())
+        error = QStringLiteral("Z2M bridge rejected the request");
+    resolveBridgeRequest(transaction, CmdStatus::Failure, response, error);
+}
+
+void Z2mAdapter::failBridgeRequests(CmdStatus status, const QString &error)
+{
+    const QHash<QString, PendingBridgeRequest> pending = std::exchange(m_bridgeRequests, {});
+    m_pendingRename.clear();
+    for (const PendingBridgeRequest &request : pending) {
+        m_timers.cancel(request.timeout);
+        request.done(status, {}, error);
+    }
+}
+
+void Z2mAdapter::resolvePublish(::phicore::MqttClient::PublishId publishId, bool ok)
+{
+    const auto it = m_publishWaiters.find(publishId);
+    if (it == m_publishWaiters.end())
+        return;
+    const std::function<void(bool)> done = std::move(it.value());
+    m_publishWaiters.erase(it);
+    done(ok);
+}
+
 bool Z2mAdapter::buildCommandPayload(const QString &deviceId,
                                      const Z2mChannelBinding &binding,
                                      const QVariant &value,
@@ -2791,7 +3897,7 @@ bool Z2mAdapter::buildCommandPayload(const QString &deviceId,
     return true;
 }
 
-double Z2mAdapter::scaleToPercent(double raw, double rawMin, double rawMax) const
+double Z2mAdapter::scaleToPercent(double raw, double rawMin, double rawMax)
 {
     if (rawMax <= rawMin)
         return raw;
@@ -2799,7 +3905,7 @@ double Z2mAdapter::scaleToPercent(double raw, double rawMin, double rawMax) cons
     return ((clamped - rawMin) / (rawMax - rawMin)) * 100.0;
 }
 
-double Z2mAdapter::scaleFromPercent(double percent, double rawMin, double rawMax) const
+double Z2mAdapter::scaleFromPercent(double percent, double rawMin, double rawMax)
 {
     if (rawMax <= rawMin)
         return percent;
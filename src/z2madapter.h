@@ -1,15 +1,25 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include <QHash>
+#include <QJsonArray>
 #include <QJsonObject>
 #include <QObject>
-#include <QPointer>
+#include <QSet>
 #include <QTimer>
 
 #include "mqttclient.h"
 
 #include "adapterinterface.h"
 #include "color.h"
+#include "z2mcommandpacer.h"
+#include "z2mpropertyfilter.h"
+#include "z2mslotmap.h"
+#include "z2mtimerwheel.h"
+#include "z2mtopicrouter.h"
 
 namespace phicore::adapter {
 
@@ -21,6 +31,10 @@ public:
     explicit Z2mAdapter(QObject *parent = nullptr);
     ~Z2mAdapter() override;
 
+    // Current device and channels, meta included, for transports that cannot
+    // apply deviceMetaUpdated patches. False for unknown devices.
+    bool deviceSnapshot(const QString &deviceExternalId, Device &device, ChannelList &channels);
+
 protected:
     bool start(QString &errorString) override;
     void stop() override;
@@ -34,16 +48,36 @@ protected:
                             const QString &channelExternalId,
                             const QVariant &value,
                             CmdId cmdId) override;
+    // One /set per endpoint, published without waiting for the coalescing
+    // window; one cmdResult per write.
+    void updateChannelStates(const QString &deviceExternalId, const QList<ChannelWrite> &writes) override;
     void updateDeviceName(const QString &deviceId, const QString &name, CmdId cmdId) override;
+    void invokeScene(const QString &sceneExternalId,
+                     const QString &groupExternalId,
+                     const QString &action,
+                     CmdId cmdId) override;
 
 private:
     struct PendingRename {
         CmdId cmdId = 0;
         QString targetName;
-        qint64 requestedAtMs = 0;
+        // Of the bridge request, see bridgeRequest().
+        QString transaction;
+    };
+
+    // Completion of a bridge request: Success or the bridge's error,
+    // Timeout, or a local failure (publish failed, adapter stopped).
+    using BridgeCallback = std::function<void(CmdStatus status, const QJsonObject &response, const QString &error)>;
+    struct PendingBridgeRequest {
+        BridgeCallback done;
+        Z2mTimerWheel::Handle timeout = 0;
     };
 
     struct Z2mChannelBinding {
+        // Converts a raw payload value to the channel value; chosen once per
+        // binding by valueDecoderFor(). Action bindings are handled separately.
+        using ValueDecoder = QVariant (*)(const Z2mChannelBinding &binding, const QJsonValue &value);
+
         QString channelId;
         QString property;
         ChannelKind kind = ChannelKind::Unknown;
@@ -64,14 +98,133 @@ private:
         bool actionIsDial = false;
         QHash<QString, int> enumRawToValue;
         QHash<int, QString> enumValueToRaw;
+        ValueDecoder decodeValue = nullptr;
+        // Minimum spacing of channelStateUpdated for this channel; 0 = none.
+        int minEmitIntervalMs = 0;
+        // Dense position within the template; indexes Z2mDeviceEntry::channelRuntime.
+        int index = -1;
     };
 
-    struct Z2mDeviceEntry {
-        Device device;
-        QString mqttId;
+    // Mutable per-channel state of one device, addressed by binding index so
+    // the state and action paths never build or hash string keys.
+    struct Z2mChannelRuntime {
+        // emitChannelState(): last emitted value and rate-limited pending value.
+        QVariant lastValue;
+        qint64 lastEmitMs = 0;
+        QVariant pendingValue;
+        qint64 pendingTsMs = 0;
+        bool hasPending = false;
+        Z2mTimerWheel::Handle flushTimer = 0;
+        // Duplicate action suppression.
+        QString lastAction;
+        qint64 lastActionTs = 0;
+        // Dial actions.
+        int lastDialValue = 0;
+        int pendingDialDirection = 0;
+        qint64 pendingDialDirectionTs = 0;
+        Z2mTimerWheel::Handle dialResetTimer = 0;
+        // Button multi-press and long-press tracking.
+        int multiPressCount = 0;
+        qint64 multiPressLastTs = 0;
+        Z2mTimerWheel::Handle multiPressTimer = 0;
+        int lastEventCode = 0;
+        qint64 lastEventTs = 0;
+        // Confirmed mode: the command held until the device reports its value.
+        CmdId confirmCmdId = 0;
+        QVariant confirmValue;
+        qint64 confirmSentMs = 0;
+        Z2mTimerWheel::Handle confirmTimer = 0;
+    };
+
+    // Publish-to-echo latency of confirmed commands for one device.
+    struct Z2mLatencyStats {
+        int samples = 0;
+        qint64 lastMs = 0;
+        double averageMs = 0.0; // exponentially weighted
+        qint64 maxMs = 0;
+        // When the stats were last reported through deviceMetaUpdated.
+        qint64 reportedMs = 0;
+    };
+
+    // Everything the action path needs from one action string, derived once.
+    struct Z2mActionInfo {
+        QString normalized;
+        int buttonId = 0;
+        ButtonEventCode code = ButtonEventCode::None;
+        bool isScene = false;
+        bool isDial = false;
+        // -1/+1 from the action name, 0 if it has no direction.
+        int dialDirection = 0;
+        // Step from the action name, 0 if it has none.
+        int dialMagnitude = 0;
+    };
+
+    // Channels and bindings compiled from a device definition. Immutable and
+    // shared by every device with the same model, model_id and definition.
+    struct Z2mDeviceTemplate {
+        QString model;
+        QString modelId;
+        // Property suppression rules for (model, modelId).
+        Z2mPropertyFilter::Scope propertyScope;
+        DeviceClass deviceClass = DeviceClass::Unknown;
         ChannelList channels;
         QHash<QString, Z2mChannelBinding> bindingsByChannel;
         QMultiHash<QString, QString> channelByProperty;
+        // Raw action value from the expose -> compiled action.
+        QHash<QString, Z2mActionInfo> actionVocabulary;
+    };
+
+    struct Z2mDeviceEntry {
+        Device device;
+        QString mqttId;
+        // Parsed ieee_address; 0 if the device has none.
+        quint64 ieee = 0;
+        std::shared_ptr<const Z2mDeviceTemplate> deviceTemplate;
+        // deviceDefinitionDigest() of the bridge/devices entry this was built
+        // from; 0 forces a rebuild.
+        size_t definitionDigest = 0;
+        // One per binding of deviceTemplate, see Z2mChannelBinding::index.
+        std::vector<Z2mChannelRuntime> channelRuntime;
+        // When last_seen was last reported through deviceMetaUpdated.
+        qint64 lastSeenReportedMs = 0;
+        Z2mLatencyStats commandLatency;
+    };
+    using DeviceHandle = Z2mSlotMap<Z2mDeviceEntry>::Handle;
+
+    struct Z2mGroupEntry {
+        Group group;
+        // Friendly name, i.e. the group's command topic.
+        QString mqttId;
+    };
+
+    // A scene stored on a Z2M group or device endpoint.
+    struct Z2mSceneEntry {
+        Scene scene;
+        // Group or device external id the scene is recalled on.
+        QString targetId;
+        // Device endpoint; empty for group scenes.
+        QString endpoint;
+        int z2mSceneId = 0;
+    };
+
+    // Channel writes to one device endpoint merged into a single /set.
+    struct Z2mCommandBatch {
+        QString externalId;
+        QString endpoint;
+        QJsonObject payload;
+        // Payload key -> cmdId of the write that last set it.
+        QHash<QString, CmdId> ownerByProperty;
+        QList<ChannelWrite> writes;
+        Z2mTimerWheel::Handle flushTimer = 0;
+        // Handed to the pacer; later writes still join until it is sent.
+        bool queued = false;
+    };
+
+    // Changes smaller than max(absolute, relative * |previous|) are not
+    // reported. Configured per ChannelKind via "channelDeadbands".
+    struct Z2mDeadband {
+        double absolute = 0.0;
+        double relative = 0.0;
     };
 
     void setConnected(bool connected, bool forceNotify = false);
@@ -83,42 +236,138 @@ private:
     void scheduleReconnect();
     void stopReconnectTimer();
     void ensureSubscriptions();
+    QSet<QString> plannedSubscriptions() const;
+    void syncSubscriptions();
+    void rebuildTopicRouter();
 
-    void handleMqttMessage(const QByteArray &message, const QString &topic);
-    void handleBridgeDevicesPayload(const QJsonArray &devices, bool fullSnapshot);
+    void handleMqttMessages(const QList<::phicore::MqttMessage> &messages);
+    void handleMqttMessage(const ::phicore::MqttMessage &mqttMessage);
+    void handleBridgeDevicesPayload(QByteArrayView devicesJson, bool fullSnapshot);
+    void handleBridgeDeviceObject(const QJsonObject &obj, QSet<DeviceHandle> &seen, bool &routesChanged);
     void handleBridgeInfoPayload(const QJsonObject &payload, qint64 tsMs);
-    void handleDeviceStatePayload(const QString &deviceId, const QJsonObject &payload, qint64 tsMs);
-    void handleAvailabilityPayload(const QString &deviceId, const QString &payload, qint64 tsMs);
+    void handleBridgeGroupsPayload(const QJsonArray &groups);
+    void handleNetworkMapPayload(const QJsonObject &response);
+    void updateGroupChannelState(const Z2mGroupEntry &group,
+                                 const QString &channelExternalId,
+                                 const QVariant &value,
+                                 CmdId cmdId);
+    const Z2mChannelBinding *groupCommandBinding(const Z2mGroupEntry &group, const QString &channelId);
+    static void collectScenes(const QJsonArray &rawScenes,
+                              const QString &targetId,
+                              const QString &scopeType,
+                              const QString &endpoint,
+                              QList<Z2mSceneEntry> &out);
+    void replaceTargetScenes(const QString &targetId, QList<Z2mSceneEntry> scenes);
+    // handle is the router's resolution of deviceId, if any; stale handles
+    // fall back to a lookup by friendly name.
+    void handleDeviceStatePayload(const QString &deviceId,
+                                  const QJsonObject &payload,
+                                  qint64 tsMs,
+                                  DeviceHandle handle = 0);
+    void handleAvailabilityPayload(const QString &deviceId,
+                                   ConnectivityStatus status,
+                                   qint64 tsMs,
+                                   DeviceHandle handle = 0);
+    void decodeBindingState(Z2mDeviceEntry &entry,
+                            const Z2mChannelBinding &binding,
+                            const QJsonValue &value,
+                            const QJsonObject &payload,
+                            qint64 tsMs);
+    void emitChannelState(Z2mDeviceEntry &entry,
+                          const Z2mChannelBinding &binding,
+                          const QVariant &value,
+                          qint64 tsMs,
+                          bool force = false);
+    bool isWithinDeadband(ChannelKind kind, const QVariant &previous, const QVariant &value) const;
+    void scheduleChannelFlush(Z2mDeviceEntry &entry, const Z2mChannelBinding &binding, int delayMs);
+    void flushPendingChannelState(const QString &externalId, const QString &channelId);
+    bool resolveChannel(const QString &externalId,
+                        const QString &channelId,
+                        Z2mDeviceEntry *&entry,
+                        const Z2mChannelBinding *&binding);
+    int minEmitIntervalFor(const Z2mChannelBinding &binding, const Z2mDeviceTemplate &compiled) const;
+    void beginStateConfirmation(Z2mDeviceEntry &entry,
+                                const Z2mChannelBinding &binding,
+                                const QVariant &value,
+                                CmdId cmdId,
+                                qint64 sentMs);
+    bool cancelStateConfirmation(const QString &externalId, const QString &channelId, CmdId cmdId);
+    void confirmChannelState(Z2mDeviceEntry &entry, const Z2mChannelBinding &binding, const QVariant &reported);
+    void expireStateConfirmation(const QString &externalId, const QString &channelId, CmdId cmdId);
+    void recordCommandLatency(Z2mDeviceEntry &entry, qint64 latencyMs);
+    static bool confirmationMatches(const Z2mChannelBinding &binding,
+                                    const QVariant &requested,
+                                    const QVariant &reported);
+
+    static Z2mChannelBinding::ValueDecoder valueDecoderFor(const Z2mChannelBinding &binding);
+    static QVariant decodeOnOffValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeBrightnessValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeDoubleValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeScaledValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeIntValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeBoolValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeEnumValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeColorValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeLinkQualityValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeMotionValue(const Z2mChannelBinding &binding, const QJsonValue &value);
+    static QVariant decodeButtonEventValue(const Z2mChannelBinding &binding, const QJsonValue &value);
 
-    Z2mDeviceEntry buildDeviceEntry(const QJsonObject &obj) const;
+    DeviceHandle deviceHandleFor(const QString &externalId) const;
+    Z2mDeviceEntry *findDeviceByExternalId(const QString &externalId);
+    Z2mDeviceEntry *findDeviceByName(const QString &mqttId);
+    void indexDevice(DeviceHandle handle, const QString &previousMqttId = QString());
+    void removeDevice(DeviceHandle handle);
+    Z2mDeviceEntry buildDeviceEntry(const QJsonObject &obj);
+    std::shared_ptr<const Z2mDeviceTemplate> deviceTemplateFor(const QJsonObject &definition, const QString &modelId);
+    void pruneDeviceTemplates();
+    Z2mDeviceTemplate compileDeviceTemplate(const QJsonObject &definition,
+                                            const QString &model,
+                                            const QString &modelId) const;
     void collectExposeEntries(const QJsonValue &value, QList<QJsonObject> &out) const;
-    void addChannelFromExpose(const QJsonObject &expose, Z2mDeviceEntry &entry) const;
-    bool isPropertySuppressed(const QString &property, const Z2mDeviceEntry &entry) const;
+    void addChannelFromExpose(const QJsonObject &expose, Z2mDeviceTemplate &compiled) const;
+    bool isPropertySuppressed(const QString &property, const Z2mDeviceTemplate &compiled) const;
     ChannelFlags flagsFromAccess(int access) const;
     QString labelFromProperty(const QString &property, const QString &fallback) const;
     DeviceClass inferDeviceClass(const QList<QJsonObject> &exposes) const;
-    ButtonEventCode actionToButtonEvent(const QString &action) const;
-    void handleButtonShortPressRelease(const QString &pressKey,
-                                       const QString &externalId,
-                                       const QString &channelId,
+    static Z2mActionInfo compileAction(const QString &rawAction);
+    static ButtonEventCode actionToButtonEvent(const QString &action);
+    void handleButtonShortPressRelease(Z2mDeviceEntry &entry,
+                                       const Z2mChannelBinding &binding,
                                        qint64 tsMs);
-    void finalizePendingButtonShortPress(const QString &pressKey,
-                                         const QString &externalId,
-                                         const QString &channelId,
+    void finalizePendingButtonShortPress(Z2mDeviceEntry &entry,
+                                         const Z2mChannelBinding &binding,
                                          qint64 tsMs = 0);
 
-    bool publishCommand(const QString &deviceId,
-                        const QJsonObject &payload,
-                        const QString &endpoint,
-                        QString &errorString);
+    ::phicore::MqttClient::PublishId publishCommand(const QString &deviceId,
+                                                    const QJsonObject &payload,
+                                                    const QString &endpoint,
+                                                    QString &errorString);
+    // Sends one command through the pacer and reports response on delivery.
+    void publishPacedCommand(const QString &lane,
+                             const QString &mqttId,
+                             const QJsonObject &payload,
+                             const QString &endpoint,
+                             CmdResponse response);
+    void awaitPublish(::phicore::MqttClient::PublishId publishId, std::function<void(bool ok)> done);
+    QString bridgeRequest(const QString &request, QJsonObject payload, BridgeCallback done);
+    bool resolveBridgeRequest(const QString &transaction,
+                              CmdStatus status,
+                              const QJsonObject &response = QJsonObject(),
+                              const QString &error = QString());
+    void handleBridgeResponse(const QJsonObject &response);
+    void failBridgeRequests(CmdStatus status, const QString &error);
+    void resolvePublish(::phicore::MqttClient::PublishId publishId, bool ok);
+    QString queueChannelWrite(const QString &deviceExternalId, const ChannelWrite &write);
+    void releaseCommandBatch(const QString &key);
+    void flushCommandBatch(const QString &key);
     bool buildCommandPayload(const QString &deviceId,
                              const Z2mChannelBinding &binding,
                              const QVariant &value,
                              QJsonObject &payload,
                              QString &errorString) const;
 
-    double scaleToPercent(double raw, double rawMin, double rawMax) const;
-    double scaleFromPercent(double percent, double rawMin, double rawMax) const;
+    static double scaleToPercent(double raw, double rawMin, double rawMax);
+    static double scaleFromPercent(double percent, double rawMin, double rawMax);
 
     ::phicore::MqttClient *m_client = nullptr;
     QTimer *m_reconnectTimer = nullptr;
@@ -127,28 +376,51 @@ private:
     bool m_bridgeOnline = true;
     bool m_lastSeenRequested = false;
     int m_retryIntervalMs = 10000;
+    // "confirmCommands": hold command results until the state echo.
+    bool m_confirmCommands = false;
     QString m_baseTopic = QStringLiteral("zigbee2mqtt");
+    std::shared_ptr<const Z2mTopicRouter> m_topicRouter;
+    QSet<QString> m_subscribedTopics;
     QJsonObject m_staticConfig;
-    QStringList m_suppressedPropertyPrefixes;
-    QHash<QString, QStringList> m_suppressedPropertyPrefixesByModel;
-    QHash<QString, QStringList> m_suppressedPropertyPrefixesByModelId;
-    QHash<QString, QStringList> m_allowedPropertyPrefixesByModel;
-    QHash<QString, QStringList> m_allowedPropertyPrefixesByModelId;
-    QHash<QString, Z2mDeviceEntry> m_devices;
-    QHash<QString, QString> m_mqttByExternal;
+    Z2mPropertyFilter m_propertyFilter;
+    QHash<int, Z2mDeadband> m_channelDeadbands;
+    QHash<int, int> m_minEmitIntervalMsByKind;
+    QHash<QString, int> m_minEmitIntervalMsByModel;
+    QHash<QString, int> m_minEmitIntervalMsByModelId;
+    QHash<int, int> m_confirmTimeoutMsByKind;
+    // "commandCoalesceMs": window for merging channel writes, 0 disables.
+    int m_commandCoalesceMs = 10;
+    // Keyed by external id and endpoint, see queueChannelWrite().
+    QHash<QString, Z2mCommandBatch> m_commandBatches;
+    // Confirmed-mode commands whose result has not been reported yet.
+    QSet<CmdId> m_heldCommands;
+    // Devices by stable handle. m_deviceByIeee is the primary index,
+    // m_deviceByName maps friendly names (and thus topics) and is the only
+    // index a rename touches.
+    Z2mSlotMap<Z2mDeviceEntry> m_devices;
+    QHash<quint64, DeviceHandle> m_deviceByIeee;
+    QHash<QString, DeviceHandle> m_deviceByName;
+    // Keyed by Group::id ("group:<z2m id>").
+    QHash<QString, Z2mGroupEntry> m_groups;
+    // Keyed by Scene::id; m_sceneIdsByTarget lists them per group/device.
+    QHash<QString, Z2mSceneEntry> m_scenes;
+    QHash<QString, QStringList> m_sceneIdsByTarget;
+    // Keyed by model, model_id and definition hash; see deviceTemplateFor().
+    QHash<QString, std::shared_ptr<const Z2mDeviceTemplate>> m_deviceTemplates;
     QHash<QString, PendingRename> m_pendingRename;
+    // Keyed by the "transaction" stamped on bridge/request/* and echoed in
+    // bridge/response/*.
+    QHash<QString, PendingBridgeRequest> m_bridgeRequests;
+    QString m_transactionPrefix;
+    quint64 m_nextTransaction = 0;
+    QHash<::phicore::MqttClient::PublishId, std::function<void(bool)>> m_publishWaiters;
     QHash<QString, QJsonObject> m_pendingStatePayloads;
-    QHash<QString, QPointer<QTimer>> m_postSetRefreshTimers;
-    QHash<QString, QPointer<QTimer>> m_dialResetTimers;
-    QHash<QString, int> m_lastDialValueByChannel;
-    QHash<QString, int> m_pendingDialDirectionByChannel;
-    QHash<QString, qint64> m_pendingDialDirectionTsByChannel;
-    QHash<QString, qint64> m_recentActionTs;
-    QHash<QString, QPointer<QTimer>> m_buttonMultiPressTimers;
-    QHash<QString, int> m_buttonMultiPressCounts;
-    QHash<QString, qint64> m_buttonMultiPressLastTs;
-    QHash<QString, int> m_buttonLastEventCode;
-    QHash<QString, qint64> m_buttonLastEventTs;
+    // Deferred actions; per-channel handles live in Z2mChannelRuntime.
+    Z2mTimerWheel m_timers;
+    // Paces every publish that becomes a Zigbee frame; keyed by device
+    // (or group) external id.
+    Z2mCommandPacer m_pacer{m_timers};
+    QHash<QString, Z2mTimerWheel::Handle> m_postSetRefreshTimers;
     QString m_coordinatorId;
     QJsonObject m_pendingBridgeInfo;
 };
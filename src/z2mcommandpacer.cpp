@@ -0,0 +1,136 @@
+#include "z2mcommandpacer.h"
+
+#include <cmath>
+#include <utility>
+
+namespace phicore::adapter {
+
+Z2mCommandPacer::Z2mCommandPacer(Z2mTimerWheel &timers)
+    : m_timers(timers)
+{
+    m_clock.start();
+}
+
+Z2mCommandPacer::~Z2mCommandPacer()
+{
+    m_timers.cancel(m_wakeTimer);
+}
+
+void Z2mCommandPacer::setRate(double ratePerSecond, int burst)
+{
+    refill();
+    m_ratePerSecond = qMax(0.0, ratePerSecond);
+    m_burst = qMax(1, burst);
+    m_tokens = qMin(m_tokens, m_burst);
+    // Start full so a burst after (re)configuration goes out at once.
+    if (size() == 0)
+        m_tokens = m_burst;
+    m_timers.cancel(std::exchange(m_wakeTimer, 0));
+    pump();
+}
+
+void Z2mCommandPacer::setParents(QHash<QString, QString> parents)
+{
+    m_parents = std::move(parents);
+}
+
+void Z2mCommandPacer::enqueue(const QString &device, Priority priority, Job job)
+{
+    if (m_ratePerSecond <= 0.0 && !m_pumping) {
+        job(true);
+        return;
+    }
+    Level &level = m_levels[static_cast<int>(priority)];
+    auto jobsIt = level.jobsByDevice.find(device);
+    if (jobsIt == level.jobsByDevice.end()) {
+        const QString router = m_parents.value(device, device);
+        auto routerIt = level.devicesByRouter.find(router);
+        if (routerIt == level.devicesByRouter.end()) {
+            routerIt = level.devicesByRouter.insert(router, {});
+            level.routerOrder.push_back(router);
+        }
+        routerIt->push_back(device);
+        jobsIt = level.jobsByDevice.insert(device, {});
+    }
+    jobsIt->push_back(std::move(job));
+    ++level.size;
+    pump();
+}
+
+void Z2mCommandPacer::clear()
+{
+    m_timers.cancel(std::exchange(m_wakeTimer, 0));
+    for (Level &level : m_levels) {
+        const QHash<QString, std::deque<Job>> jobs = std::exchange(level.jobsByDevice, {});
+        level.routerOrder.clear();
+        level.devicesByRouter.clear();
+        level.size = 0;
+        for (const std::deque<Job> &deviceJobs : jobs) {
+            for (const Job &job : deviceJobs)
+                job(false);
+        }
+    }
+}
+
+void Z2mCommandPacer::refill()
+{
+    const qint64 nowMs = m_clock.elapsed();
+    m_tokens = qMin(m_burst, m_tokens + (nowMs - m_lastRefillMs) * m_ratePerSecond / 1000.0);
+    m_lastRefillMs = nowMs;
+}
+
+void Z2mCommandPacer::pump()
+{
+    // Jobs enqueued by a running job are picked up by the loop below.
+    if (m_pumping)
+        return;
+    m_pumping = true;
+    refill();
+    while (size() > 0 && (m_ratePerSecond <= 0.0 || m_tokens >= 1.0)) {
+        Level &level = m_levels[0].size > 0 ? m_levels[0] : m_levels[1];
+        Job job = takeNext(level);
+        if (m_ratePerSecond > 0.0)
+            m_tokens -= 1.0;
+        job(true);
+    }
+    m_pumping = false;
+    if (size() > 0)
+        scheduleWake();
+}
+
+Z2mCommandPacer::Job Z2mCommandPacer::takeNext(Level &level)
+{
+    const QString router = level.routerOrder.front();
+    level.routerOrder.pop_front();
+    std::deque<QString> &devices = level.devicesByRouter[router];
+    const QString device = devices.front();
+    devices.pop_front();
+
+    auto jobsIt = level.jobsByDevice.find(device);
+    Job job = std::move(jobsIt->front());
+    jobsIt->pop_front();
+    if (jobsIt->empty())
+        level.jobsByDevice.erase(jobsIt);
+    else
+        devices.push_back(device);
+
+    if (devices.empty())
+        level.devicesByRouter.remove(router);
+    else
+        level.routerOrder.push_back(router);
+    --level.size;
+    return job;
+}
+
+void Z2mCommandPacer::scheduleWake()
+{
+    if (m_timers.isScheduled(m_wakeTimer))
+        return;
+    const int delayMs = qMax(1, static_cast<int>(std::ceil((1.0 - m_tokens) * 1000.0 / m_ratePerSecond)));
+    m_wakeTimer = m_timers.schedule(delayMs, [this]() {
+        m_wakeTimer = 0;
+        pump();
+    });
+}
+
+} // namespace phicore::adapter
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+
+#include "z2mtimerwheel.h"
+
+namespace phicore::adapter {
+
+// Outbound scheduler for messages that turn into Zigbee frames (/set,
+// /get). A global token bucket bounds the rate handed to the coordinator;
+// within it, commands always go before refreshes, and each priority is
+// served round-robin over parent routers and then over the devices behind
+// each router, so one busy device (or one busy branch of the mesh) cannot
+// starve the rest.
+//
+// Jobs run with send == true when their token is granted, or with
+// send == false if they are dropped by clear(). A job may enqueue further
+// jobs. Not thread-safe: use from the timer wheel's thread only.
+class Z2mCommandPacer
+{
+public:
+    enum class Priority {
+        Command = 0,
+        Refresh = 1
+    };
+    using Job = std::function<void(bool send)>;
+
+    explicit Z2mCommandPacer(Z2mTimerWheel &timers);
+    ~Z2mCommandPacer();
+    Q_DISABLE_COPY_MOVE(Z2mCommandPacer)
+
+    // ratePerSecond <= 0 disables pacing: jobs run when enqueued.
+    void setRate(double ratePerSecond, int burst);
+    // Device -> parent router, both as used in enqueue(). Devices without a
+    // parent form their own lane. Applies to devices queued from now on.
+    void setParents(QHash<QString, QString> parents);
+    const QHash<QString, QString> &parents() const noexcept { return m_parents; }
+
+    void enqueue(const QString &device, Priority priority, Job job);
+    // Drops every queued job, calling it with send == false.
+    void clear();
+    int size() const noexcept { return m_levels[0].size + m_levels[1].size; }
+
+private:
+    struct Level {
+        // Router lanes with queued jobs, served round-robin.
+        std::deque<QString> routerOrder;
+        QHash<QString, std::deque<QString>> devicesByRouter;
+        QHash<QString, std::deque<Job>> jobsByDevice;
+        int size = 0;
+    };
+
+    void refill();
+    void pump();
+    Job takeNext(Level &level);
+    void scheduleWake();
+
+    Z2mTimerWheel &m_timers;
+    Level m_levels[2];
+    QHash<QString, QString> m_parents;
+    double m_ratePerSecond = 0.0;
+    double m_burst = 1.0;
+    double m_tokens = 1.0;
+    QElapsedTimer m_clock;
+    qint64 m_lastRefillMs = 0;
+    Z2mTimerWheel::Handle m_wakeTimer = 0;
+    bool m_pumping = false;
+};
+
+} // namespace phicore::adapter
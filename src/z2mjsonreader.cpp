@@ -0,0 +1,149 @@
+#include "z2mjsonreader.h"
+
+namespace phicore::adapter {
+
+namespace {
+
+bool isJsonSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+qsizetype skipSpace(QByteArrayView json, qsizetype pos)
+{
+    while (pos < json.size() && isJsonSpace(json.at(pos)))
+        ++pos;
+    return pos;
+}
+
+// pos points at the opening quote. Returns the index just past the closing
+// quote, or -1 if the string is unterminated.
+qsizetype scanString(QByteArrayView json, qsizetype pos)
+{
+    for (++pos; pos < json.size(); ++pos) {
+        const char c = json.at(pos);
+        if (c == '\\')
+            ++pos;
+        else if (c == '"')
+            return pos + 1;
+    }
+    return -1;
+}
+
+// pos points at the first character of a value. Returns the index just past
+// the value, or -1 on a structural error.
+qsizetype scanValue(QByteArrayView json, qsizetype pos)
+{
+    if (pos >= json.size())
+        return -1;
+    const char first = json.at(pos);
+    if (first == '"')
+        return scanString(json, pos);
+    if (first == '{' || first == '[') {
+        int depth = 0;
+        while (pos < json.size()) {
+            const char c = json.at(pos);
+            if (c == '"') {
+                pos = scanString(json, pos);
+                if (pos < 0)
+                    return -1;
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0)
+                    return pos + 1;
+            }
+            ++pos;
+        }
+        return -1;
+    }
+    while (pos < json.size()) {
+        const char c = json.at(pos);
+        if (c == ',' || c == '}' || c == ']' || isJsonSpace(c))
+            break;
+        ++pos;
+    }
+    return pos;
+}
+
+} // namespace
+
+Z2mJsonArrayReader::Z2mJsonArrayReader(QByteArrayView json)
+    : m_json(json)
+{
+    m_pos = skipSpace(m_json, 0);
+    if (m_pos >= m_json.size() || m_json.at(m_pos) != '[') {
+        m_error = true;
+        m_done = true;
+        return;
+    }
+    ++m_pos;
+}
+
+bool Z2mJsonArrayReader::next(QByteArrayView &element)
+{
+    if (m_done)
+        return false;
+    m_pos = skipSpace(m_json, m_pos);
+    if (m_pos >= m_json.size()) {
+        m_error = true;
+        m_done = true;
+        return false;
+    }
+    if (m_json.at(m_pos) == ']') {
+        m_done = true;
+        return false;
+    }
+    if (!m_first) {
+        if (m_json.at(m_pos) != ',') {
+            m_error = true;
+            m_done = true;
+            return false;
+        }
+        m_pos = skipSpace(m_json, m_pos + 1);
+    }
+    const qsizetype end = scanValue(m_json, m_pos);
+    if (end <= m_pos) {
+        m_error = true;
+        m_done = true;
+        return false;
+    }
+    element = m_json.sliced(m_pos, end - m_pos);
+    m_pos = end;
+    m_first = false;
+    return true;
+}
+
+QByteArrayView z2mJsonObjectMember(QByteArrayView object, QByteArrayView key)
+{
+    qsizetype pos = skipSpace(object, 0);
+    if (pos >= object.size() || object.at(pos) != '{')
+        return {};
+    ++pos;
+    while (true) {
+        pos = skipSpace(object, pos);
+        if (pos >= object.size() || object.at(pos) != '"')
+            return {};
+        const qsizetype keyEnd = scanString(object, pos);
+        if (keyEnd < 0)
+            return {};
+        const QByteArrayView name = object.sliced(pos + 1, keyEnd - pos - 2);
+        pos = skipSpace(object, keyEnd);
+        if (pos >= object.size() || object.at(pos) != ':')
+            return {};
+        pos = skipSpace(object, pos + 1);
+        const qsizetype valueEnd = scanValue(object, pos);
+        if (valueEnd <= pos)
+            return {};
+        if (name == key)
+            return object.sliced(pos, valueEnd - pos);
+        pos = skipSpace(object, valueEnd);
+        if (pos >= object.size() || object.at(pos) != ',')
+            return {};
+        ++pos;
+    }
+}
+
+} // namespace phicore::adapter
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QByteArrayView>
+
+namespace phicore::adapter {
+
+// Incremental reader over a JSON array held in memory. next() only scans
+// for the bounds of the following element (strings, escapes and nesting are
+// honoured) and returns it as a view, so callers can parse one element at a
+// time instead of materializing a DOM for the whole array.
+//
+// The reader does not validate element contents; a malformed element is
+// returned as-is and left to the caller's parser. Structural errors (missing
+// brackets, unterminated strings) stop iteration and set hasError().
+class Z2mJsonArrayReader
+{
+public:
+    explicit Z2mJsonArrayReader(QByteArrayView json);
+
+    bool next(QByteArrayView &element);
+    bool hasError() const noexcept { return m_error; }
+
+private:
+    QByteArrayView m_json;
+    qsizetype m_pos = 0;
+    bool m_first = true;
+    bool m_done = false;
+    bool m_error = false;
+};
+
+// Returns the raw value of a top-level member of a JSON object, or a null
+// view if the member is absent or the input is not an object. key is
+// compared against the raw (still escaped) member name.
+QByteArrayView z2mJsonObjectMember(QByteArrayView object, QByteArrayView key);
+
+} // namespace phicore::adapter
@@ -0,0 +1,110 @@
+#include "z2mpropertyfilter.h"
+
+#include <QChar>
+
+namespace phicore::adapter {
+
+namespace {
+
+char16_t foldCase(QChar c)
+{
+    return c.toCaseFolded().unicode();
+}
+
+} // namespace
+
+Z2mPropertyFilter::Z2mPropertyFilter(const QStringList &suppressed,
+                                     const QHash<QString, QStringList> &suppressedByModel,
+                                     const QHash<QString, QStringList> &suppressedByModelId,
+                                     const QHash<QString, QStringList> &allowedByModel,
+                                     const QHash<QString, QStringList> &allowedByModelId)
+{
+    m_nodes.emplace_back();
+    addPrefixes(suppressed, SuppressGlobal, -1);
+    addScopedPrefixes(suppressedByModel, SuppressModel, m_modelScopes);
+    addScopedPrefixes(allowedByModel, AllowModel, m_modelScopes);
+    addScopedPrefixes(suppressedByModelId, SuppressModelId, m_modelIdScopes);
+    addScopedPrefixes(allowedByModelId, AllowModelId, m_modelIdScopes);
+}
+
+void Z2mPropertyFilter::addScopedPrefixes(const QHash<QString, QStringList> &prefixesByKey,
+                                          Rule rule,
+                                          QHash<QString, qint32> &scopes)
+{
+    for (auto it = prefixesByKey.cbegin(); it != prefixesByKey.cend(); ++it) {
+        auto scopeIt = scopes.find(it.key());
+        if (scopeIt == scopes.end())
+            scopeIt = scopes.insert(it.key(), m_nextScope++);
+        addPrefixes(it.value(), rule, scopeIt.value());
+    }
+}
+
+void Z2mPropertyFilter::addPrefixes(const QStringList &prefixes, Rule rule, qint32 scope)
+{
+    for (const QString &prefix : prefixes) {
+        if (prefix.isEmpty())
+            continue;
+        qint32 node = 0;
+        for (const QChar c : prefix) {
+            const quint64 key = (static_cast<quint64>(node) << 16) | foldCase(c);
+            auto edgeIt = m_edges.constFind(key);
+            if (edgeIt == m_edges.cend()) {
+                edgeIt = m_edges.insert(key, static_cast<qint32>(m_nodes.size()));
+                m_nodes.emplace_back();
+            }
+            node = edgeIt.value();
+        }
+        if (scope < 0)
+            m_nodes[node].globalRules |= rule;
+        else
+            m_nodes[node].tags.push_back({scope, rule});
+    }
+}
+
+qint32 Z2mPropertyFilter::child(qint32 node, char16_t c) const
+{
+    return m_edges.value((static_cast<quint64>(node) << 16) | c, -1);
+}
+
+Z2mPropertyFilter::Scope Z2mPropertyFilter::scopeFor(const QString &model, const QString &modelId) const
+{
+    Scope scope;
+    if (!model.isEmpty())
+        scope.model = m_modelScopes.value(model, -1);
+    if (!modelId.isEmpty())
+        scope.modelId = m_modelIdScopes.value(modelId, -1);
+    return scope;
+}
+
+bool Z2mPropertyFilter::isSuppressed(QStringView property, Scope scope) const
+{
+    if (m_edges.isEmpty())
+        return false;
+    // Every node passed ends some prefix of the property; collect the rules
+    // of all of them.
+    quint8 rules = 0;
+    qint32 node = 0;
+    for (const QChar c : property) {
+        node = child(node, foldCase(c));
+        if (node < 0)
+            break;
+        const Node &current = m_nodes[node];
+        rules |= current.globalRules;
+        for (const Tag &tag : current.tags) {
+            const bool modelTag = tag.rule == SuppressModel || tag.rule == AllowModel;
+            if (tag.scope == (modelTag ? scope.model : scope.modelId))
+                rules |= tag.rule;
+        }
+    }
+
+    bool suppressed = rules & (SuppressGlobal | SuppressModel);
+    if (rules & AllowModel)
+        suppressed = false;
+    if (rules & SuppressModelId)
+        suppressed = true;
+    if (rules & AllowModelId)
+        suppressed = false;
+    return suppressed;
+}
+
+} // namespace phicore::adapter
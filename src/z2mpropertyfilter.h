@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+namespace phicore::adapter {
+
+// Compiled form of the property suppression config. All prefixes (global,
+// per model and per model_id, suppress and allow) share one case-folded
+// trie whose nodes carry the rules ending there, so matching a property
+// costs one walk over its characters regardless of the number of rules.
+//
+// Model and model_id rules are tagged with interned scope ids; scopeFor()
+// resolves a device's pair once (store the result with its template) and
+// isSuppressed() then only compares integers.
+class Z2mPropertyFilter
+{
+public:
+    struct Scope {
+        qint32 model = -1;
+        qint32 modelId = -1;
+    };
+
+    Z2mPropertyFilter() = default;
+    Z2mPropertyFilter(const QStringList &suppressed,
+                      const QHash<QString, QStringList> &suppressedByModel,
+                      const QHash<QString, QStringList> &suppressedByModelId,
+                      const QHash<QString, QStringList> &allowedByModel,
+                      const QHash<QString, QStringList> &allowedByModelId);
+
+    Scope scopeFor(const QString &model, const QString &modelId) const;
+
+    // Global and per-model suppressions apply unless a per-model allow
+    // matches; per-model_id suppressions and allows are applied on top.
+    bool isSuppressed(QStringView property, Scope scope) const;
+
+private:
+    enum Rule : quint8 {
+        SuppressGlobal = 0x01,
+        SuppressModel = 0x02,
+        AllowModel = 0x04,
+        SuppressModelId = 0x08,
+        AllowModelId = 0x10
+    };
+
+    struct Tag {
+        qint32 scope;
+        quint8 rule;
+    };
+
+    struct Node {
+        quint8 globalRules = 0;
+        std::vector<Tag> tags;
+    };
+
+    void addPrefixes(const QStringList &prefixes, Rule rule, qint32 scope);
+    void addScopedPrefixes(const QHash<QString, QStringList> &prefixesByKey,
+                           Rule rule,
+                           QHash<QString, qint32> &scopes);
+    qint32 child(qint32 node, char16_t c) const;
+
+    std::vector<Node> m_nodes;
+    // (parent node << 16 | case-folded UTF-16 unit) -> child node.
+    QHash<quint64, qint32> m_edges;
+    QHash<QString, qint32> m_modelScopes;
+    QHash<QString, qint32> m_modelIdScopes;
+    qint32 m_nextScope = 0;
+};
+
+} // namespace phicore::adapter
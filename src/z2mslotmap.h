@@ -0,0 +1,126 @@
+#pragma once
+
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <QtGlobal>
+
+namespace phicore::adapter {
+
+// Generational slot storage. Values never move once inserted, so pointers
+// and handles stay valid until the value is removed; a handle to a removed
+// value resolves to nullptr even after its slot has been reused. Handle 0 is
+// never issued and can be used as "none".
+//
+// Removing values (including the visited one) from inside forEach() is
+// allowed; inserting is not.
+template <typename T>
+class Z2mSlotMap
+{
+public:
+    using Handle = quint64;
+
+    Handle insert(T value)
+    {
+        quint32 index;
+        if (!m_free.empty()) {
+            index = m_free.back();
+            m_free.pop_back();
+        } else {
+            index = static_cast<quint32>(m_slots.size());
+            m_slots.emplace_back();
+        }
+        Slot &slot = m_slots[index];
+        slot.value.emplace(std::move(value));
+        ++m_count;
+        return (static_cast<quint64>(slot.generation) << 32) | (index + 1);
+    }
+
+    T *get(Handle handle)
+    {
+        Slot *slot = slotFor(handle);
+        return slot ? &*slot->value : nullptr;
+    }
+
+    const T *get(Handle handle) const
+    {
+        return const_cast<Z2mSlotMap *>(this)->get(handle);
+    }
+
+    bool contains(Handle handle) const { return get(handle) != nullptr; }
+
+    bool remove(Handle handle)
+    {
+        Slot *slot = slotFor(handle);
+        if (!slot)
+            return false;
+        slot->value.reset();
+        // Invalidates outstanding handles; skip 0 so handles never collide.
+        if (++slot->generation == 0)
+            slot->generation = 1;
+        m_free.push_back(static_cast<quint32>((handle & 0xffffffffu) - 1));
+        --m_count;
+        return true;
+    }
+
+    void clear()
+    {
+        for (quint32 index = 0; index < m_slots.size(); ++index) {
+            if (m_slots[index].value)
+                remove(handleAt(index));
+        }
+    }
+
+    int size() const noexcept { return m_count; }
+    bool isEmpty() const noexcept { return m_count == 0; }
+
+    // Calls fn(Handle, T &) for every stored value in slot order.
+    template <typename Fn>
+    void forEach(Fn &&fn)
+    {
+        for (quint32 index = 0; index < m_slots.size(); ++index) {
+            if (m_slots[index].value)
+                fn(handleAt(index), *m_slots[index].value);
+        }
+    }
+
+    template <typename Fn>
+    void forEach(Fn &&fn) const
+    {
+        for (quint32 index = 0; index < m_slots.size(); ++index) {
+            if (m_slots[index].value)
+                fn(handleAt(index), std::as_const(*m_slots[index].value));
+        }
+    }
+
+private:
+    struct Slot {
+        std::optional<T> value;
+        quint32 generation = 1;
+    };
+
+    Handle handleAt(quint32 index) const
+    {
+        return (static_cast<quint64>(m_slots[index].generation) << 32) | (index + 1);
+    }
+
+    Slot *slotFor(Handle handle)
+    {
+        const quint32 low = static_cast<quint32>(handle & 0xffffffffu);
+        if (low == 0 || low > m_slots.size())
+            return nullptr;
+        Slot &slot = m_slots[low - 1];
+        if (!slot.value || slot.generation != static_cast<quint32>(handle >> 32))
+            return nullptr;
+        return &slot;
+    }
+
+    // std::deque keeps elements in place when growing.
+    std::deque<Slot> m_slots;
+    std::vector<quint32> m_free;
+    int m_count = 0;
+};
+
+} // namespace phicore::adapter
@@ -0,0 +1,243 @@
+#include "z2mtimerwheel.h"
+
+#include <utility>
+
+namespace phicore::adapter {
+
+namespace {
+
+constexpr qint32 kFreeSlot = -1;
+constexpr qint32 kDueSlot = -2;
+
+} // namespace
+
+Z2mTimerWheel::Z2mTimerWheel(QObject *context)
+    : m_timer(new QTimer(context))
+{
+    m_slots.fill(-1);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_timer, &QTimer::timeout, m_timer, [this]() { onTimeout(); });
+    m_clock.start();
+}
+
+Z2mTimerWheel::~Z2mTimerWheel()
+{
+    m_timer->stop();
+    m_timer->disconnect();
+}
+
+quint64 Z2mTimerWheel::nowTick() const
+{
+    return static_cast<quint64>(m_clock.elapsed()) / kTickMs;
+}
+
+Z2mTimerWheel::Handle Z2mTimerWheel::schedule(int delayMs, Callback callback)
+{
+    // Nothing pending means nothing to catch up on; avoid walking idle ticks.
+    if (m_count == 0)
+        m_currentTick = nowTick();
+
+    qint32 index;
+    if (!m_freeNodes.empty()) {
+        index = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    } else {
+        index = static_cast<qint32>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    Node &node = m_nodes[index];
+    // Round up so a callback never runs before its delay has elapsed.
+    const quint64 dueMs = static_cast<quint64>(m_clock.elapsed()) + static_cast<quint64>(qMax(0, delayMs));
+    node.callback = std::move(callback);
+    node.expiresTick = qMax((dueMs + kTickMs - 1) / kTickMs, m_currentTick + 1);
+    ++m_count;
+    place(index);
+    rearm();
+    return (static_cast<quint64>(node.generation) << 32) | static_cast<quint32>(index + 1);
+}
+
+bool Z2mTimerWheel::cancel(Handle handle)
+{
+    const qint32 index = indexOf(handle);
+    if (index < 0)
+        return false;
+    if (m_nodes[index].slot >= 0)
+        unlink(index);
+    release(index);
+    rearm();
+    return true;
+}
+
+bool Z2mTimerWheel::isScheduled(Handle handle) const
+{
+    return indexOf(handle) >= 0;
+}
+
+void Z2mTimerWheel::clear()
+{
+    for (qint32 index = 0; index < static_cast<qint32>(m_nodes.size()); ++index) {
+        if (m_nodes[index].slot != kFreeSlot)
+            release(index);
+    }
+    m_slots.fill(-1);
+    m_level0Count = 0;
+    m_timer->stop();
+}
+
+qint32 Z2mTimerWheel::indexOf(Handle handle) const
+{
+    const quint32 low = static_cast<quint32>(handle & 0xffffffffu);
+    if (low == 0 || low > m_nodes.size())
+        return -1;
+    const qint32 index = static_cast<qint32>(low - 1);
+    const Node &node = m_nodes[index];
+    if (node.slot == kFreeSlot || node.generation != static_cast<quint32>(handle >> 32))
+        return -1;
+    return index;
+}
+
+void Z2mTimerWheel::place(qint32 index)
+{
+    const quint64 expires = m_nodes[index].expiresTick;
+    const quint64 delta = expires > m_currentTick ? expires - m_currentTick : 0;
+    int slot;
+    if (delta < kLevel0Slots) {
+        slot = static_cast<int>(expires & (kLevel0Slots - 1));
+    } else if (delta < (quint64(1) << (kLevel0Bits + kLevelNBits))) {
+        slot = kLevel0Slots + static_cast<int>((expires >> kLevel0Bits) & (kLevelNSlots - 1));
+    } else if (delta < (quint64(1) << (kLevel0Bits + 2 * kLevelNBits))) {
+        slot = kLevel0Slots + kLevelNSlots
+            + static_cast<int>((expires >> (kLevel0Bits + kLevelNBits)) & (kLevelNSlots - 1));
+    } else {
+        // Beyond the wheel: park in the last slot to be reached, re-placed
+        // when that slot cascades.
+        slot = kLevel0Slots + kLevelNSlots
+            + static_cast<int>(((m_currentTick >> (kLevel0Bits + kLevelNBits)) + kLevelNSlots - 1)
+                               & (kLevelNSlots - 1));
+    }
+    link(index, slot);
+}
+
+void Z2mTimerWheel::link(qint32 index, int slot)
+{
+    Node &node = m_nodes[index];
+    node.slot = slot;
+    node.prev = -1;
+    node.next = m_slots[slot];
+    if (node.next >= 0)
+        m_nodes[node.next].prev = index;
+    m_slots[slot] = index;
+    if (slot < kLevel0Slots)
+        ++m_level0Count;
+}
+
+void Z2mTimerWheel::unlink(qint32 index)
+{
+    Node &node = m_nodes[index];
+    if (node.prev >= 0)
+        m_nodes[node.prev].next = node.next;
+    else
+        m_slots[node.slot] = node.next;
+    if (node.next >= 0)
+        m_nodes[node.next].prev = node.prev;
+    if (node.slot < kLevel0Slots)
+        --m_level0Count;
+    node.prev = -1;
+    node.next = -1;
+    node.slot = kDueSlot;
+}
+
+void Z2mTimerWheel::release(qint32 index)
+{
+    Node &node = m_nodes[index];
+    node.callback = nullptr;
+    node.slot = kFreeSlot;
+    node.prev = -1;
+    node.next = -1;
+    // Invalidates outstanding handles; skip 0 so handles never collide.
+    if (++node.generation == 0)
+        node.generation = 1;
+    m_freeNodes.push_back(index);
+    --m_count;
+}
+
+void Z2mTimerWheel::cascade(int level)
+{
+    const int shift = level == 1 ? kLevel0Bits : kLevel0Bits + kLevelNBits;
+    const int slot = kLevel0Slots + (level - 1) * kLevelNSlots
+        + static_cast<int>((m_currentTick >> shift) & (kLevelNSlots - 1));
+    qint32 index = m_slots[slot];
+    m_slots[slot] = -1;
+    while (index >= 0) {
+        const qint32 next = m_nodes[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+void Z2mTimerWheel::runDue(int slot)
+{
+    if (m_slots[slot] < 0)
+        return;
+    // Detach first: callbacks may schedule or cancel (including each other).
+    std::vector<std::pair<qint32, quint32>> due;
+    for (qint32 index = m_slots[slot]; index >= 0; index = m_nodes[index].next)
+        due.emplace_back(index, m_nodes[index].generation);
+    for (const auto &[index, generation] : due)
+        unlink(index);
+
+    for (const auto &[index, generation] : due) {
+        Node &node = m_nodes[index];
+        if (node.generation != generation || node.slot != kDueSlot)
+            continue;
+        Callback callback = std::move(node.callback);
+        release(index);
+        if (callback)
+            callback();
+    }
+}
+
+void Z2mTimerWheel::advanceTo(quint64 tick)
+{
+    while (m_currentTick < tick && m_count > 0) {
+        ++m_currentTick;
+        if ((m_currentTick & (kLevel0Slots - 1)) == 0) {
+            if (((m_currentTick >> kLevel0Bits) & (kLevelNSlots - 1)) == 0)
+                cascade(2);
+            cascade(1);
+        }
+        runDue(static_cast<int>(m_currentTick & (kLevel0Slots - 1)));
+    }
+    if (m_count == 0)
+        m_currentTick = tick;
+}
+
+void Z2mTimerWheel::onTimeout()
+{
+    advanceTo(nowTick());
+    rearm();
+}
+
+void Z2mTimerWheel::rearm()
+{
+    if (m_count == 0) {
+        m_timer->stop();
+        return;
+    }
+    // Wake at the next occupied level-0 slot, or at the next level-0 wrap
+    // where the upper levels cascade.
+    quint64 wakeTick = (m_currentTick | (kLevel0Slots - 1)) + 1;
+    if (m_level0Count > 0) {
+        for (quint64 tick = m_currentTick + 1; tick < wakeTick; ++tick) {
+            if (m_slots[tick & (kLevel0Slots - 1)] >= 0) {
+                wakeTick = tick;
+                break;
+            }
+        }
+    }
+    const qint64 delayMs = static_cast<qint64>(wakeTick) * kTickMs - m_clock.elapsed();
+    m_timer->start(static_cast<int>(qBound<qint64>(0, delayMs, kLevel0Slots * kTickMs)));
+}
+
+} // namespace phicore::adapter
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QtGlobal>
+
+namespace phicore::adapter {
+
+// Hierarchical timing wheel for the adapter's deferred actions (debounces,
+// press windows, timeouts). All timers share one single-shot QTimer that is
+// only armed for the next occupied tick, so thousands of pending actions
+// cost no QObjects and no Qt timer registrations.
+//
+// Resolution is kTickMs; delays are rounded up to whole ticks. Three levels
+// of 256/64/64 slots cover ~2.9 h, longer delays are cascaded again.
+// schedule() and cancel() are O(1). Callbacks run on the context's thread;
+// a handle is invalid once its callback ran or it was cancelled.
+//
+// Not thread-safe: use from the context object's thread only.
+class Z2mTimerWheel
+{
+public:
+    using Handle = quint64;
+    using Callback = std::function<void()>;
+
+    static constexpr int kTickMs = 10;
+
+    explicit Z2mTimerWheel(QObject *context);
+    ~Z2mTimerWheel();
+    Q_DISABLE_COPY_MOVE(Z2mTimerWheel)
+
+    Handle schedule(int delayMs, Callback callback);
+    // Returns false if the handle already fired or was cancelled.
+    bool cancel(Handle handle);
+    bool isScheduled(Handle handle) const;
+    // Cancels everything without running callbacks.
+    void clear();
+    int size() const noexcept { return m_count; }
+
+private:
+    static constexpr int kLevel0Bits = 8;
+    static constexpr int kLevelNBits = 6;
+    static constexpr int kLevel0Slots = 1 << kLevel0Bits;
+    static constexpr int kLevelNSlots = 1 << kLevelNBits;
+    static constexpr int kLevels = 3;
+    static constexpr int kSlotCount = kLevel0Slots + (kLevels - 1) * kLevelNSlots;
+
+    struct Node {
+        Callback callback;
+        quint64 expiresTick = 0;
+        quint32 generation = 1;
+        qint32 prev = -1;
+        qint32 next = -1;
+        qint32 slot = -1; // -1: free, -2: due and about to run
+    };
+
+    quint64 nowTick() const;
+    void place(qint32 index);
+    void link(qint32 index, int slot);
+    void unlink(qint32 index);
+    void release(qint32 index);
+    qint32 indexOf(Handle handle) const;
+    void cascade(int level);
+    void onTimeout();
+    void advanceTo(quint64 tick);
+    void runDue(int slot);
+    void rearm();
+
+    // Child of the context so it follows moveToThread().
+    QTimer *m_timer = nullptr;
+    QElapsedTimer m_clock;
+    quint64 m_currentTick = 0;
+    std::vector<Node> m_nodes;
+    std::vector<qint32> m_freeNodes;
+    std::array<qint32, kSlotCount> m_slots;
+    int m_count = 0;
+    int m_level0Count = 0;
+};
+
+} // namespace phicore::adapter
@@ -0,0 +1,122 @@
+#include "z2mtopicrouter.h"
+
+#include <QJsonParseError>
+
+namespace phicore::adapter {
+
+namespace {
+
+bool startsWithJsonObject(QByteArrayView payload)
+{
+    for (const char c : payload) {
+        if (c == ' ' || (c >= '\t' && c <= '\r'))
+            continue;
+        return c == '{';
+    }
+    return false;
+}
+
+Z2mTopicClass classifyUnknownTopic(QByteArrayView suffix)
+{
+    if (suffix.startsWith("bridge/response/"))
+        return Z2mTopicClass::BridgeResponse;
+    if (suffix.isEmpty() || suffix.startsWith("bridge/"))
+        return Z2mTopicClass::Unhandled;
+    const qsizetype slashIndex = suffix.indexOf('/');
+    if (slashIndex < 0)
+        return Z2mTopicClass::DeviceState;
+    if (slashIndex == 0)
+        return Z2mTopicClass::Unhandled;
+    const QByteArrayView rest = suffix.sliced(slashIndex);
+    if (rest == QByteArrayView("/availability"))
+        return Z2mTopicClass::Availability;
+    if (rest == QByteArrayView("/action"))
+        return Z2mTopicClass::Action;
+    return Z2mTopicClass::Unhandled;
+}
+
+} // namespace
+
+Z2mTopicRouter::Z2mTopicRouter(const QByteArray &topicPrefix, const QHash<QString, quint64> &devices)
+    : m_topicPrefix(topicPrefix)
+{
+    m_routes.reserve(10 + devices.size() * 5);
+    addRoute(QByteArrayLiteral("bridge/state"), Z2mTopicClass::BridgeState);
+    addRoute(QByteArrayLiteral("bridge/health"), Z2mTopicClass::BridgeHealth);
+    addRoute(QByteArrayLiteral("bridge/info"), Z2mTopicClass::BridgeInfo);
+    addRoute(QByteArrayLiteral("bridge/devices"), Z2mTopicClass::BridgeDevices);
+    addRoute(QByteArrayLiteral("bridge/response/devices"), Z2mTopicClass::BridgeDevicesResponse);
+    addRoute(QByteArrayLiteral("bridge/groups"), Z2mTopicClass::BridgeGroups);
+    addRoute(QByteArrayLiteral("bridge/response/networkmap"), Z2mTopicClass::BridgeNetworkMap);
+
+    for (auto it = devices.cbegin(); it != devices.cend(); ++it) {
+        const QString &deviceId = it.key();
+        const QByteArray name = deviceId.toUtf8();
+        if (name.isEmpty())
+            continue;
+        addRoute(name, Z2mTopicClass::DeviceState, deviceId, it.value());
+        addRoute(name + "/availability", Z2mTopicClass::Availability, deviceId, it.value());
+        addRoute(name + "/action", Z2mTopicClass::Action, deviceId, it.value());
+        // Our own (and other clients') commands; never treat them as state.
+        addRoute(name + "/set", Z2mTopicClass::Unhandled, deviceId, it.value());
+        addRoute(name + "/get", Z2mTopicClass::Unhandled, deviceId, it.value());
+    }
+}
+
+void Z2mTopicRouter::addRoute(const QByteArray &suffix,
+                              Z2mTopicClass topicClass,
+                              const QString &deviceId,
+                              quint64 device)
+{
+    Route route;
+    route.topicClass = topicClass;
+    route.deviceId = deviceId;
+    route.device = device;
+    m_routes.insert(suffix, route);
+}
+
+Z2mTopicRouter::Route Z2mTopicRouter::route(QByteArrayView topic) const
+{
+    if (m_topicPrefix.isEmpty() || !topic.startsWith(m_topicPrefix))
+        return {};
+    const QByteArrayView suffix = topic.sliced(m_topicPrefix.size());
+    const auto it = m_routes.constFind(QByteArray::fromRawData(suffix.data(), suffix.size()));
+    if (it != m_routes.cend())
+        return it.value();
+
+    Route route;
+    route.topicClass = classifyUnknownTopic(suffix);
+    if (route.topicClass != Z2mTopicClass::Unhandled && route.topicClass != Z2mTopicClass::BridgeResponse) {
+        const qsizetype slashIndex = suffix.indexOf('/');
+        route.deviceId = QString::fromUtf8(slashIndex < 0 ? suffix : suffix.first(slashIndex));
+    }
+    return route;
+}
+
+QJsonDocument Z2mTopicRouter::decodePayload(Z2mTopicClass topicClass, QByteArrayView payload)
+{
+    switch (topicClass) {
+    case Z2mTopicClass::Unhandled:
+    case Z2mTopicClass::BridgeState:
+    // Streamed one device at a time by the adapter to bound peak memory.
+    case Z2mTopicClass::BridgeDevices:
+    case Z2mTopicClass::BridgeDevicesResponse:
+        return {};
+    case Z2mTopicClass::Availability:
+    case Z2mTopicClass::Action:
+        // Both topics may carry plain text instead of JSON.
+        if (!startsWithJsonObject(payload))
+            return {};
+        break;
+    default:
+        break;
+    }
+    QJsonParseError err;
+    QJsonDocument doc = QJsonDocument::fromJson(
+        QByteArray::fromRawData(payload.data(), payload.size()), &err);
+    if (err.error != QJsonParseError::NoError)
+        return {};
+    return doc;
+}
+
+} // namespace phicore::adapter
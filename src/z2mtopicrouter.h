@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QJsonDocument>
+#include <QString>
+
+namespace phicore::adapter {
+
+enum class Z2mTopicClass : int {
+    Unhandled = 0,
+    BridgeState,
+    BridgeHealth,
+    // Any bridge/response/* except devices and networkmap.
+    BridgeResponse,
+    BridgeInfo,
+    BridgeDevices,
+    BridgeDevicesResponse,
+    BridgeGroups,
+    BridgeNetworkMap,
+    Availability,
+    Action,
+    DeviceState
+};
+
+// Immutable topic -> (class, device) table for one base topic. Bridge topics
+// and every topic of a known device are precompiled into a single hash over
+// the full topic, so a lookup is one probe and friendly names containing '/'
+// resolve correctly. Topics of devices not (yet) known fall back to
+// structural classification, which assumes names without '/'.
+//
+// Instances are shared read-only between the adapter thread and the MQTT
+// worker's decode stage; rebuild on device add/remove/rename or base topic
+// change instead of mutating.
+class Z2mTopicRouter
+{
+public:
+    struct Route {
+        Z2mTopicClass topicClass = Z2mTopicClass::Unhandled;
+        // Friendly name for device topics.
+        QString deviceId;
+        // Caller-supplied device handle for known devices, 0 otherwise.
+        quint64 device = 0;
+    };
+
+    Z2mTopicRouter() = default;
+    // devices maps friendly names to opaque handles returned in Route.
+    Z2mTopicRouter(const QByteArray &topicPrefix, const QHash<QString, quint64> &devices);
+
+    const QByteArray &topicPrefix() const noexcept { return m_topicPrefix; }
+    Route route(QByteArrayView topic) const;
+
+    // Parses the payload if the topic class carries JSON. Returns a null
+    // document for plain-text payloads and parse errors.
+    static QJsonDocument decodePayload(Z2mTopicClass topicClass, QByteArrayView payload);
+
+private:
+    void addRoute(const QByteArray &suffix,
+                  Z2mTopicClass topicClass,
+                  const QString &deviceId = {},
+                  quint64 device = 0);
+
+    QByteArray m_topicPrefix;
+    QHash<QByteArray, Route> m_routes;
+};
+
+} // namespace phicore::adapter